@@ -8,7 +8,12 @@
  *   - В конце файла глобальные алиасы (Stop/Bus/BusStat), чтобы тесты Task2 не упали
  **************************************************************************************************/
 
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -19,12 +24,295 @@ namespace transport_catalogue::domain {
 struct Stop {
     std::string name;
     transport_catalogue::geo::Coordinates coord{0.0, 0.0};
+    // ADDED: плотный номер остановки в каталоге (0..N-1) — индекс для массивов "по остановкам"
+    std::uint32_t id = 0;
+};
+
+// ADDED: метаданные сегментов маршрута, 2 бита на сегмент (сегмент k: stops[k] -> stops[k + 1])
+//  - two_way:   в этом же маршруте есть обратный сегмент stops[k + 1] -> stops[k]
+//  - canonical: направление "каноническое" (from->id <= to->id); при two_way
+//               рендер сдвигает НЕканоническую половину, чтобы "туда/обратно" не слипались
+// Считаются один раз в TransportCatalogue::AddBus — рендерам не нужны хеш-таблицы рёбер.
+class SegmentFlags {
+public:
+    void Assign(std::size_t segments) {
+        size_ = segments;
+        words_.assign((segments * kBitsPerSegment + kWordBits - 1) / kWordBits, 0);
+    }
+
+    void Set(std::size_t k, bool two_way, bool canonical) {
+        const std::size_t bit = k * kBitsPerSegment;
+        std::uint64_t& w = words_[bit / kWordBits];
+        const std::size_t shift = bit % kWordBits;
+        w &= ~(std::uint64_t{3} << shift);
+        w |= (std::uint64_t{two_way} | (std::uint64_t{canonical} << 1)) << shift;
+    }
+
+    bool IsTwoWay(std::size_t k) const { return Get(k) & 1u; }
+    bool IsCanonical(std::size_t k) const { return Get(k) & 2u; }
+
+    std::size_t Size() const { return size_; }
+    std::size_t CapacityBytes() const { return words_.capacity() * sizeof(std::uint64_t); }
+
+private:
+    static constexpr std::size_t kBitsPerSegment = 2;
+    static constexpr std::size_t kWordBits = 64;
+
+    unsigned Get(std::size_t k) const {
+        const std::size_t bit = k * kBitsPerSegment;
+        return static_cast<unsigned>(words_[bit / kWordBits] >> (bit % kWordBits)) & 3u;
+    }
+
+    std::vector<std::uint64_t> words_;
+    std::size_t size_ = 0;
+};
+
+// ADDED: кодировка остановок маршрутов в StopSequenceStore
+enum class StopEncoding : std::uint8_t {
+    kPlain,        // uint32 id на остановку, произвольный доступ O(1)
+    kDeltaVarint,  // первый id + разности соседних (zigzag + varint): после перенумерации
+                   // вдоль кривой Гильберта соседи близки — обычно 1–2 байта на остановку;
+                   // читается последовательно (итератором), Id(k) — O(k)
+};
+
+namespace detail {
+
+inline void AppendVarint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+// читает varint с p и сдвигает p за него
+inline std::uint64_t ReadVarint(const std::uint8_t*& p) {
+    std::uint64_t v = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        v |= std::uint64_t{*p++ & 0x7Fu} << shift;
+        shift += 7;
+    }
+    return v | (std::uint64_t{*p++} << shift);
+}
+
+// читает varint, который заканчивается прямо перед p, и сдвигает p на его начало.
+// Перед ним всегда есть последний байт предыдущего varint (старший бит 0) — граница маршрута
+// не нужна, если так читаются только разности (элементы 1..n-1).
+inline std::uint64_t ReadVarintBackward(const std::uint8_t*& p) {
+    const std::uint8_t* start = p - 1;
+    while (start[-1] & 0x80) {
+        --start;
+    }
+    p = start;
+    return ReadVarint(start);
+}
+
+inline std::uint64_t ZigZag(std::int64_t v) {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+inline std::int64_t UnZigZag(std::uint64_t v) {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+} // namespace detail
+
+// ADDED: остановки всех маршрутов в формате CSR — маршруты подряд в одном массиве +
+// массив смещений (маршрут r: [offsets[r], offsets[r + 1])). В kPlain массив — uint32 id,
+// в kDeltaVarint — байты кодировки (см. StopEncoding). Кодировка выбирается до первого маршрута.
+class StopSequenceStore {
+public:
+    explicit StopSequenceStore(const std::pmr::deque<Stop>* stops) : stops_(stops) {}
+
+    void SetEncoding(StopEncoding encoding) {
+        assert(Routes() == 0 && "encoding must be chosen before the first route");
+        encoding_ = encoding;
+    }
+    StopEncoding GetEncoding() const { return encoding_; }
+
+    // дописывает маршрут (хранимую часть), возвращает его номер
+    std::uint32_t Append(const std::vector<std::uint32_t>& ids) {
+        if (encoding_ == StopEncoding::kPlain) {
+            ids_.insert(ids_.end(), ids.begin(), ids.end());
+            offsets_.push_back(static_cast<std::uint32_t>(ids_.size()));
+        } else {
+            for (std::size_t k = 0; k < ids.size(); ++k) {
+                detail::AppendVarint(bytes_, k == 0
+                    ? ids[0]
+                    : detail::ZigZag(std::int64_t{ids[k]} - std::int64_t{ids[k - 1]}));
+            }
+            offsets_.push_back(static_cast<std::uint32_t>(bytes_.size()));
+        }
+        stored_ += ids.size();
+        return static_cast<std::uint32_t>(Routes() - 1);
+    }
+
+    // после загрузки: отдать запас ёмкости (массивы растут геометрически)
+    void ShrinkToFit() {
+        ids_.shrink_to_fit();
+        bytes_.shrink_to_fit();
+        offsets_.shrink_to_fit();
+    }
+
+    std::size_t Routes() const { return offsets_.size() - 1; }
+    std::size_t StoredStops() const { return stored_; }
+    std::size_t CapacityBytes() const {
+        return ids_.capacity() * sizeof(std::uint32_t) + bytes_.capacity()
+             + offsets_.capacity() * sizeof(std::uint32_t);
+    }
+
+    const std::pmr::deque<Stop>* Stops() const { return stops_; }
+    const std::uint32_t* PlainIds(std::uint32_t route) const { return ids_.data() + offsets_[route]; }
+    const std::uint8_t* Encoded(std::uint32_t route) const { return bytes_.data() + offsets_[route]; }
+
+private:
+    const std::pmr::deque<Stop>* stops_;
+    StopEncoding encoding_ = StopEncoding::kPlain;
+    std::vector<std::uint32_t> ids_;
+    std::vector<std::uint8_t> bytes_;
+    std::vector<std::uint32_t> offsets_{0};
+    std::size_t stored_ = 0;
+};
+
+// ADDED: остановки одного маршрута — вид на StopSequenceStore каталога (номер маршрута,
+// а не адрес данных: вид переживает рост и перекодирование хранилища).
+// Разыменование итератора даёт const Stop*, Id() — id без обращения к Stop.
+//
+// Линейный маршрут (A - B - C) хранится один раз: A, B, C. Обратная половина виртуальная —
+// вид отдаёт A, B, C, B, A (size() = 2 * stored - 1), как раньше отдавал развёрнутый вектор.
+// В kDeltaVarint обратная половина декодируется с конца (разности вычитаются).
+class StopSpan {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = const Stop*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Stop* const*;
+        using reference = const Stop*;
+
+        Iterator() = default;
+        Iterator(const StopSequenceStore& store, std::uint32_t route,
+                 std::size_t stored, std::size_t size, std::size_t k)
+            : stops_(store.Stops())
+            , plain_(store.GetEncoding() == StopEncoding::kPlain)
+            , stored_(stored)
+            , size_(size)
+            , k_(k) {
+            if (plain_) {
+                ids_ = store.PlainIds(route);
+            } else {
+                pos_ = store.Encoded(route);
+                if (k_ == 0 && size_ > 0) {
+                    id_ = static_cast<std::uint32_t>(detail::ReadVarint(pos_));
+                }
+            }
+        }
+
+        std::uint32_t Id() const {
+            return plain_ ? ids_[k_ < stored_ ? k_ : 2 * stored_ - 2 - k_] : id_;
+        }
+        const Stop* operator*() const { return &(*stops_)[Id()]; }
+
+        Iterator& operator++() {
+            ++k_;
+            if (!plain_ && k_ < size_) {
+                // прямая половина: + разность текущего; обратная: - разность покидаемого
+                id_ = k_ < stored_
+                    ? static_cast<std::uint32_t>(id_ + detail::UnZigZag(detail::ReadVarint(pos_)))
+                    : static_cast<std::uint32_t>(id_ - detail::UnZigZag(detail::ReadVarintBackward(pos_)));
+            }
+            return *this;
+        }
+        Iterator operator++(int) { Iterator old = *this; ++*this; return old; }
+
+        bool operator==(const Iterator& other) const { return k_ == other.k_; }
+        bool operator!=(const Iterator& other) const { return k_ != other.k_; }
+
+    private:
+        const std::pmr::deque<Stop>* stops_ = nullptr;
+        const std::uint32_t* ids_ = nullptr;  // kPlain
+        const std::uint8_t* pos_ = nullptr;   // kDeltaVarint: конец кодировки текущего элемента
+        std::uint32_t id_ = 0;                // kDeltaVarint: id текущего элемента
+        bool plain_ = true;
+        std::size_t stored_ = 0;
+        std::size_t size_ = 0;
+        std::size_t k_ = 0;
+    };
+
+    StopSpan() = default;
+    StopSpan(const StopSequenceStore* store, std::uint32_t route, std::uint32_t stored, bool mirrored)
+        : store_(store), route_(route), stored_(stored), mirrored_(mirrored && stored > 0) {}
+
+    // полная последовательность (для линейного маршрута — с обратной половиной)
+    std::size_t size() const { return mirrored_ ? 2 * std::size_t{stored_} - 1 : stored_; }
+    bool empty() const { return stored_ == 0; }
+
+    // id k-й остановки маршрута: kPlain — O(1), kDeltaVarint — O(k); в циклах — итератор
+    std::uint32_t Id(std::size_t k) const {
+        const std::size_t i = k < stored_ ? k : 2 * std::size_t{stored_} - 2 - k;
+        if (store_->GetEncoding() == StopEncoding::kPlain) {
+            return store_->PlainIds(route_)[i];
+        }
+        Iterator it = begin();
+        for (std::size_t j = 0; j < i; ++j) {
+            ++it;
+        }
+        return it.Id();
+    }
+    const Stop* operator[](std::size_t k) const { return &(*store_->Stops())[Id(k)]; }
+    const Stop* front() const { return (*this)[0]; }
+    const Stop* back() const { return (*this)[size() - 1]; }
+
+    Iterator begin() const { return store_ ? Iterator(*store_, route_, stored_, size(), 0) : Iterator(); }
+    Iterator end() const { return store_ ? Iterator(*store_, route_, stored_, size(), size()) : Iterator(); }
+
+    // Реально хранимая часть (у линейного маршрута — только прямая половина): [begin(), StoredEnd())
+    std::size_t StoredSize() const { return stored_; }
+    bool IsMirrored() const { return mirrored_; }
+    Iterator StoredEnd() const { return store_ ? Iterator(*store_, route_, stored_, size(), stored_) : Iterator(); }
+
+private:
+    const StopSequenceStore* store_ = nullptr;
+    std::uint32_t route_ = 0;
+    std::uint32_t stored_ = 0;
+    bool mirrored_ = false;
+};
+
+// ADDED: последовательность остановок, общая для всех маршрутов с одинаковым списком
+// (варианты, ночные версии, дубли фидов). Каталог заводит её один раз (hash-consing в AddBus):
+// хранение, флаги сегментов и статистика считаются на уникальную последовательность, а не на Bus.
+struct Route {
+    StopSpan stops;
+    SegmentFlags segments;  // stops.size() - 1 сегментов (или 0)
+    std::uint32_t id = 0;   // плотный номер (0..R-1) — индекс для массивов "по последовательностям"
 };
 
 struct Bus {
     std::string name;
-    std::vector<const Stop*> stops;
-    bool is_roundtrip = false;
+    StopSpan stops;  // ADDED: вид на StopSequenceStore каталога (= route->stops, хранение общее)
+    bool is_roundtrip = false;  // ADDED: true — кольцевой (A > B > A), false — линейный (A - B)
+    const Route* route = nullptr;  // ADDED: общая последовательность (флаги сегментов — route->segments)
+};
+
+// Список маршрутов остановки — отрезок CSR-индекса каталога (см. TransportCatalogue::GetBusSpanByStop).
+// Действителен до следующего изменения каталога.
+class BusSpan {
+public:
+    BusSpan() = default;
+    BusSpan(const Bus* const* first, std::size_t size) : first_(first), size_(size) {}
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Bus* operator[](std::size_t i) const { return first_[i]; }
+
+    const Bus* const* begin() const { return first_; }
+    const Bus* const* end() const { return first_ + size_; }
+
+private:
+    const Bus* const* first_ = nullptr;
+    std::size_t size_ = 0;
 };
 
 struct BusStat {
@@ -0,0 +1,371 @@
+// flat_hash_map.h
+#pragma once
+
+/**************************************************************************************************
+ * FlatHashMap — хеш-таблица с открытой адресацией в духе SwissTable для индексов каталога
+ *
+ * Зачем:
+ *   - std::unordered_map = узел в куче на каждую запись + переход по указателю на каждый поиск
+ *   - здесь записи лежат в одном плоском массиве слотов, рядом — массив контрольных байт
+ *
+ * Устройство:
+ *   - хеш делится на H1 (старшие биты: с какой группы начинать) и H2 (младшие 7 бит)
+ *   - контрольный байт слота: kEmpty (0x80) или H2 занятого слота (0..127)
+ *   - слоты разбиты на группы по 16; группа проверяется целиком: SSE2 сравнивает 16 контрольных
+ *     байт с H2 одной инструкцией (без SSE2 — тот же результат обычным циклом)
+ *   - пробирование по группам квадратичное, заполнение не выше 7/8, рост — вдвое
+ *
+ * Ограничения (каталогу не нужно):
+ *   - удаления нет (только вставка / поиск / clear)
+ *   - вставка с ростом таблицы перемещает значения: указатели/итераторы на записи недействительны
+ *   - value_type = std::pair<Key, Value>; ключ найденной записи менять нельзя
+ *
+ * Поиск гетерогенный: find(k) принимает любой тип, который понимают Hash и Eq
+ * (например, string_view при прозрачном StrViewHasher + std::equal_to<>).
+ * Память берётся у std::pmr::memory_resource (по умолчанию — обычная куча).
+ **************************************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSPORT_CATALOGUE_FLAT_HASH_SSE2 1
+#endif
+
+namespace transport_catalogue::util {
+
+namespace detail {
+
+constexpr std::int8_t kCtrlEmpty = static_cast<std::int8_t>(-128);  // 0x80
+constexpr std::size_t kGroupWidth = 16;
+
+inline int LowestBit(std::uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// 16 контрольных байт группы; Match* возвращают битовую маску совпавших позиций
+class Group {
+public:
+    explicit Group(const std::int8_t* ctrl) {
+#ifdef TRANSPORT_CATALOGUE_FLAT_HASH_SSE2
+        ctrl_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+        for (std::size_t i = 0; i < kGroupWidth; ++i) {
+            ctrl_[i] = ctrl[i];
+        }
+#endif
+    }
+
+    std::uint32_t Match(std::int8_t h2) const {
+#ifdef TRANSPORT_CATALOGUE_FLAT_HASH_SSE2
+        return static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+#else
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < kGroupWidth; ++i) {
+            mask |= std::uint32_t{ctrl_[i] == h2} << i;
+        }
+        return mask;
+#endif
+    }
+
+    std::uint32_t MatchEmpty() const { return Match(kCtrlEmpty); }
+
+private:
+#ifdef TRANSPORT_CATALOGUE_FLAT_HASH_SSE2
+    __m128i ctrl_;
+#else
+    std::int8_t ctrl_[kGroupWidth];
+#endif
+};
+
+// std::hash для указателей и целых — тождественный: перемешиваем, чтобы H2 и H1 были случайными
+inline std::size_t MixHash(std::size_t h) {
+    std::uint64_t x = static_cast<std::uint64_t>(h) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<std::size_t>(x ^ (x >> 32));
+}
+
+} // namespace detail
+
+template <typename Key, typename Value,
+          typename Hash = std::hash<Key>, typename Eq = std::equal_to<Key>>
+class FlatHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>;
+    using size_type = std::size_t;
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+        Iterator() = default;
+        Iterator(const std::int8_t* ctrl, pointer slot, pointer end)
+            : ctrl_(ctrl), slot_(slot), end_(end) { SkipEmpty(); }
+        // iterator -> const_iterator
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        Iterator(const Iterator<false>& other)  // NOLINT(google-explicit-constructor)
+            : ctrl_(other.ctrl_), slot_(other.slot_), end_(other.end_) {}
+
+        reference operator*() const { return *slot_; }
+        pointer operator->() const { return slot_; }
+
+        Iterator& operator++() {
+            ++ctrl_;
+            ++slot_;
+            SkipEmpty();
+            return *this;
+        }
+        Iterator operator++(int) { Iterator old = *this; ++*this; return old; }
+
+        bool operator==(const Iterator& other) const { return slot_ == other.slot_; }
+        bool operator!=(const Iterator& other) const { return slot_ != other.slot_; }
+
+    private:
+        friend class FlatHashMap;
+        friend class Iterator<true>;
+
+        void SkipEmpty() {
+            while (slot_ != end_ && *ctrl_ == detail::kCtrlEmpty) {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+        const std::int8_t* ctrl_ = nullptr;
+        pointer slot_ = nullptr;
+        pointer end_ = nullptr;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit FlatHashMap(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : resource_(resource) {}
+
+    ~FlatHashMap() { Release(); }
+
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+    FlatHashMap(FlatHashMap&& other) noexcept { Steal(other); }
+    FlatHashMap& operator=(FlatHashMap&& other) noexcept {
+        if (this != &other) {
+            Release();
+            Steal(other);
+        }
+        return *this;
+    }
+
+    size_type size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_type capacity() const { return capacity_; }
+
+    iterator begin() { return {ctrl_, slots_, slots_ + capacity_}; }
+    iterator end() { return {nullptr, slots_ + capacity_, slots_ + capacity_}; }
+    const_iterator begin() const { return {ctrl_, slots_, slots_ + capacity_}; }
+    const_iterator end() const { return {nullptr, slots_ + capacity_, slots_ + capacity_}; }
+
+    // Сколько байт занимает таблица (контрольные байты + слоты), без "хвостов" значений
+    size_type AllocatedBytes() const { return capacity_ ? LayoutBytes(capacity_) : 0; }
+
+    template <typename K>
+    iterator find(const K& key) {
+        const size_type i = FindIndex(key);
+        return i == kNpos ? end() : iterator(ctrl_ + i, slots_ + i, slots_ + capacity_);
+    }
+
+    template <typename K>
+    const_iterator find(const K& key) const {
+        const size_type i = FindIndex(key);
+        return i == kNpos ? end() : const_iterator(ctrl_ + i, slots_ + i, slots_ + capacity_);
+    }
+
+    template <typename K>
+    bool contains(const K& key) const { return FindIndex(key) != kNpos; }
+
+    // Вставка, если ключа нет: Value строится из args (как у std::unordered_map::try_emplace)
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        const std::size_t hash = detail::MixHash(Hash{}(key));
+        if (const size_type i = FindIndex(key, hash); i != kNpos) {
+            return {iterator(ctrl_ + i, slots_ + i, slots_ + capacity_), false};
+        }
+        if ((size_ + 1) * 8 > capacity_ * 7) {
+            Rehash(capacity_ ? capacity_ * 2 : detail::kGroupWidth);
+        }
+        const size_type i = FreeIndex(hash);
+        ::new (static_cast<void*>(slots_ + i)) value_type(
+            std::piecewise_construct, std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+        ctrl_[i] = H2(hash);
+        ++size_;
+        return {iterator(ctrl_ + i, slots_ + i, slots_ + capacity_), true};
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(const Key& key, Args&&... args) {
+        return try_emplace(key, std::forward<Args>(args)...);
+    }
+
+    Value& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    // Готовит таблицу под count записей без роста
+    void reserve(size_type count) {
+        size_type cap = detail::kGroupWidth;
+        while (count * 8 > cap * 7) {
+            cap *= 2;
+        }
+        if (cap > capacity_) {
+            Rehash(cap);
+        }
+    }
+
+    // Удаляет все записи, ёмкость сохраняется
+    void clear() {
+        for (size_type i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] != detail::kCtrlEmpty) {
+                slots_[i].~value_type();
+                ctrl_[i] = detail::kCtrlEmpty;
+            }
+        }
+        size_ = 0;
+    }
+
+private:
+    static constexpr size_type kNpos = static_cast<size_type>(-1);
+
+    static std::int8_t H2(std::size_t hash) { return static_cast<std::int8_t>(hash & 0x7F); }
+    static std::size_t H1(std::size_t hash) { return hash >> 7; }
+
+    // [контрольные байты][выравнивание][слоты]
+    static size_type SlotsOffset(size_type capacity) {
+        const size_type align = alignof(value_type);
+        return (capacity + align - 1) / align * align;
+    }
+    static size_type LayoutBytes(size_type capacity) {
+        return SlotsOffset(capacity) + capacity * sizeof(value_type);
+    }
+    static constexpr size_type LayoutAlign() {
+        return alignof(value_type) > alignof(std::max_align_t) ? alignof(value_type)
+                                                                 : alignof(std::max_align_t);
+    }
+
+    template <typename K>
+    size_type FindIndex(const K& key) const {
+        return capacity_ ? FindIndex(key, detail::MixHash(Hash{}(key))) : kNpos;
+    }
+
+    template <typename K>
+    size_type FindIndex(const K& key, std::size_t hash) const {
+        if (!capacity_) {
+            return kNpos;
+        }
+        const size_type groups_mask = capacity_ / detail::kGroupWidth - 1;
+        size_type group = H1(hash) & groups_mask;
+        for (size_type step = 1;; ++step) {
+            const size_type base = group * detail::kGroupWidth;
+            const detail::Group g(ctrl_ + base);
+            for (std::uint32_t m = g.Match(H2(hash)); m != 0; m &= m - 1) {
+                const size_type i = base + static_cast<size_type>(detail::LowestBit(m));
+                if (Eq{}(slots_[i].first, key)) {
+                    return i;
+                }
+            }
+            if (g.MatchEmpty() != 0) {
+                return kNpos;  // без удалений пустой слот в группе = конец цепочки
+            }
+            group = (group + step) & groups_mask;
+        }
+    }
+
+    size_type FreeIndex(std::size_t hash) const {
+        const size_type groups_mask = capacity_ / detail::kGroupWidth - 1;
+        size_type group = H1(hash) & groups_mask;
+        for (size_type step = 1;; ++step) {
+            const size_type base = group * detail::kGroupWidth;
+            if (const std::uint32_t m = detail::Group(ctrl_ + base).MatchEmpty(); m != 0) {
+                return base + static_cast<size_type>(detail::LowestBit(m));
+            }
+            group = (group + step) & groups_mask;
+        }
+    }
+
+    void Rehash(size_type new_capacity) {
+        std::int8_t* old_ctrl = ctrl_;
+        value_type* old_slots = slots_;
+        const size_type old_capacity = capacity_;
+
+        Allocate(new_capacity);
+        for (size_type i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] == detail::kCtrlEmpty) {
+                continue;
+            }
+            const std::size_t hash = detail::MixHash(Hash{}(old_slots[i].first));
+            const size_type j = FreeIndex(hash);
+            ::new (static_cast<void*>(slots_ + j)) value_type(std::move(old_slots[i]));
+            ctrl_[j] = H2(hash);
+            old_slots[i].~value_type();
+        }
+        if (old_capacity) {
+            resource_->deallocate(old_ctrl, LayoutBytes(old_capacity), LayoutAlign());
+        }
+    }
+
+    void Allocate(size_type capacity) {
+        void* block = resource_->allocate(LayoutBytes(capacity), LayoutAlign());
+        ctrl_ = static_cast<std::int8_t*>(block);
+        slots_ = reinterpret_cast<value_type*>(static_cast<char*>(block) + SlotsOffset(capacity));
+        capacity_ = capacity;
+        for (size_type i = 0; i < capacity; ++i) {
+            ctrl_[i] = detail::kCtrlEmpty;
+        }
+    }
+
+    void Release() {
+        if (!capacity_) {
+            return;
+        }
+        clear();
+        resource_->deallocate(ctrl_, LayoutBytes(capacity_), LayoutAlign());
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+    }
+
+    void Steal(FlatHashMap& other) {
+        resource_ = other.resource_;
+        ctrl_ = std::exchange(other.ctrl_, nullptr);
+        slots_ = std::exchange(other.slots_, nullptr);
+        capacity_ = std::exchange(other.capacity_, 0);
+        size_ = std::exchange(other.size_, 0);
+    }
+
+    std::pmr::memory_resource* resource_ = nullptr;
+    std::int8_t* ctrl_ = nullptr;
+    value_type* slots_ = nullptr;
+    size_type capacity_ = 0;
+    size_type size_ = 0;
+};
+
+} // namespace transport_catalogue::util
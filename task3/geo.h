@@ -8,8 +8,12 @@
  *
  * ❌ REMOVED:
  *   - Глобальное объявление Coordinates/ComputeDistance (теперь внутри geo)
+ *
+ * ADDED:
+ *   - BoundingBox — bbox набора точек (проекции карт, ключи перенумерации)
  **************************************************************************************************/
 
+#include <algorithm>
 #include <cmath>
 
 namespace transport_catalogue::geo {
@@ -36,6 +40,25 @@ inline double ComputeDistance(Coordinates from, Coordinates to) {
         * 6371000;
 }
 
+// bbox набора точек: Extend по каждой точке (один проход), empty — пока точек не было
+struct BoundingBox {
+    Coordinates min{0.0, 0.0};
+    Coordinates max{0.0, 0.0};
+    bool empty = true;
+
+    void Extend(Coordinates c) {
+        if (empty) {
+            min = max = c;
+            empty = false;
+            return;
+        }
+        min.lat = std::min(min.lat, c.lat);
+        min.lng = std::min(min.lng, c.lng);
+        max.lat = std::max(max.lat, c.lat);
+        max.lng = std::max(max.lng, c.lng);
+    }
+};
+
 } // namespace transport_catalogue::geo
 
 // COMPAT: старые глобальные имена для Task2-тестов
@@ -3,7 +3,6 @@
 
 #include <algorithm>
 #include <cassert>
-#include <iterator>
 #include <cmath>      // ADDED: для std::nan
 
 /**************************************************************************************************
@@ -64,16 +63,19 @@ std::vector<std::string_view> Split(std::string_view string, char delim) {
     return result;
 }
 
-std::vector<std::string_view> ParseRoute(std::string_view route) {
+// Кольцевой маршрут (A > B > A) — остановки как есть.
+// Линейный (A - B - C) — только прямая половина: обратную каталог не хранит, а отдаёт
+// виртуально (Bus::stops = A, B, C, B, A), см. domain::StopSpan.
+struct ParsedRoute {
+    std::vector<std::string_view> stops;
+    bool is_roundtrip = false;
+};
+
+ParsedRoute ParseRoute(std::string_view route) {
     if (route.find('>') != route.npos) {
-        return Split(route, '>');
+        return {Split(route, '>'), true};
     }
-
-    auto stops = Split(route, '-');
-    std::vector<std::string_view> results(stops.begin(), stops.end());
-    results.insert(results.end(), std::next(stops.rbegin()), stops.rend());
-
-    return results;
+    return {Split(route, '-'), false};
 }
 
 CommandDescription ParseCommandDescription(std::string_view line) {
@@ -102,25 +104,80 @@ CommandDescription ParseCommandDescription(std::string_view line) {
 
 void InputReader::ParseLine(std::string_view line) {
     auto command_description = detail::ParseCommandDescription(line);
-    if (command_description) {
-        commands_.push_back(std::move(command_description));
+    if (!command_description) {
+        return;
+    }
+    // сначала сохраняем: символы ссылаются на строки уже внутри commands_
+    const auto& c = commands_.emplace_back(std::move(command_description));
+
+    if (c.command == "Stop") {
+        stop_symbols_.push_back(InternSymbol(c.id));
+    } else if (c.command == "Bus") {
+        auto route = detail::ParseRoute(c.description);
+        ParsedBus bus;
+        bus.symbols.reserve(route.stops.size());
+        for (std::string_view stop : route.stops) {
+            bus.symbols.push_back(InternSymbol(stop));
+        }
+        bus.is_roundtrip = route.is_roundtrip;
+        parsed_buses_.push_back(std::move(bus));
     }
 }
 
+std::uint32_t InputReader::InternSymbol(std::string_view name) {
+    if (auto it = symbol_by_name_.find(name); it != symbol_by_name_.end()) {
+        return it->second;
+    }
+    const auto symbol = static_cast<std::uint32_t>(symbol_names_.size());
+    symbol_names_.push_back(name);
+    symbol_by_name_.try_emplace(name, symbol);
+    return symbol;
+}
+
 void InputReader::ApplyCommands(transport_catalogue::catalogue::TransportCatalogue& cat) const {
+    using transport_catalogue::catalogue::BusDescription;
+    using transport_catalogue::catalogue::StopDescription;
+
+    // символ -> Stop::id; kUnresolved — имя не объявлено командой Stop в этом вводе
+    constexpr std::uint32_t kUnresolved = ~std::uint32_t{0};
+    std::vector<std::uint32_t> stop_id_by_symbol(symbol_names_.size(), kUnresolved);
+
+    // новые остановки получат id подряд, начиная с текущего числа остановок (см. BulkLoad)
+    std::vector<StopDescription> stops;
+    stops.reserve(stop_symbols_.size());
+    auto stop_symbol = stop_symbols_.begin();
     for (const auto& c : commands_) {
         if (c.command == "Stop") {
-            auto crd = detail::ParseCoordinates(c.description);
-            cat.AddStop(c.id, crd);
+            const auto id = static_cast<std::uint32_t>(cat.GetAllStops().size() + stops.size());
+            stop_id_by_symbol[*stop_symbol++] = id;
+            stops.push_back({c.id, detail::ParseCoordinates(c.description)});
         }
     }
 
+    std::vector<BusDescription> buses;
+    buses.reserve(parsed_buses_.size());
+    auto bus = parsed_buses_.begin();
     for (const auto& c : commands_) {
         if (c.command == "Bus") {
-            auto route = detail::ParseRoute(c.description);
-            cat.AddBus(c.id, route);
+            BusDescription& desc = buses.emplace_back();
+            desc.name = c.id;
+            desc.is_roundtrip = bus->is_roundtrip;
+            desc.stop_ids.reserve(bus->symbols.size());
+            for (const std::uint32_t symbol : bus->symbols) {
+                std::uint32_t& id = stop_id_by_symbol[symbol];
+                if (id == kUnresolved) {
+                    // остановка из прошлого ввода в этом же каталоге: один поиск на имя
+                    const auto* s = cat.FindStop(symbol_names_[symbol]);
+                    assert(s != nullptr && "Stop not found while adding bus (input should be valid)");
+                    id = s->id;
+                }
+                desc.stop_ids.push_back(id);
+            }
+            ++bus;
         }
     }
+
+    cat.BulkLoad(stops, buses);
 }
 
 } // namespace transport_catalogue::io
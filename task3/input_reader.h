@@ -11,10 +11,13 @@
  *   - глобальные объявления структур и класса (теперь внутри io)
  **************************************************************************************************/
 
+#include <cstdint>
+#include <deque>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "flat_hash_map.h"
 #include "geo.h"
 #include "transport_catalogue.h"
 
@@ -39,7 +42,26 @@ public:
     void ApplyCommands(transport_catalogue::catalogue::TransportCatalogue& catalogue) const;
 
 private:
-    std::vector<CommandDescription> commands_;
+    // ===================== Таблица символов =====================
+    // Каждое различное имя остановки хешируется один раз — при разборе строки, где оно
+    // встретилось, и получает номер символа. Маршруты хранятся уже номерами символов,
+    // поэтому ApplyCommands строит их по Stop::id без единого поиска по строке.
+    std::uint32_t InternSymbol(std::string_view name);
+
+    struct ParsedBus {
+        std::vector<std::uint32_t> symbols;  // остановки маршрута (номера символов)
+        bool is_roundtrip = false;
+    };
+
+    // deque: строки команд не переезжают, символы ссылаются прямо на имена внутри них
+    std::deque<CommandDescription> commands_;
+
+    std::vector<std::uint32_t> stop_symbols_;  // символ имени каждой команды Stop (по порядку)
+    std::vector<ParsedBus> parsed_buses_;      // каждая команда Bus (по порядку)
+
+    std::vector<std::string_view> symbol_names_;  // номер символа -> имя (внутри commands_)
+    util::FlatHashMap<std::string_view, std::uint32_t,
+                      transport_catalogue::catalogue::StrViewHasher, std::equal_to<>> symbol_by_name_;
 };
 
 } // namespace transport_catalogue::io
@@ -25,9 +25,15 @@
 
 #ifdef INTERACTIVE
 #include "map_renderer.h"
+#include "render_cache.h"
+#include "thread_pool.h"
 #include <algorithm>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string_view>
 #include <vector>
-#include <tuple>
 #endif
 
 using namespace std;
@@ -35,11 +41,30 @@ using namespace std;
 // ADDED: локальные using — чтобы не писать длинные имена
 using transport_catalogue::io::InputReader;
 using transport_catalogue::stat::ParseAndPrintStat;
+using transport_catalogue::stat::PrintMemoryUsage;
 using transport_catalogue::catalogue::TransportCatalogue;
 
 #ifdef INTERACTIVE
 using transport_catalogue::render::RenderBusSvg;
 using transport_catalogue::render::RenderStopSvg;
+using transport_catalogue::render::RenderNetworkSvg;
+using transport_catalogue::render::SvgWriter;
+using transport_catalogue::render::MakeSafeFilename;
+using transport_catalogue::render::RenderCache;
+using transport_catalogue::render::CachedSvg;
+
+// ADDED: точность координат в SVG-файлах (2 знака после точки — с запасом для экранных пикселей)
+constexpr int kSvgPrecision = 2;
+
+// ADDED: компактные SVG (<path> вместо <line>, <use> для маркеров, CSS-классы) — в 3-5 раз меньше
+constexpr bool kSvgCompact = true;
+
+// ADDED: размер карты всей сети (больше, чем у карты одного маршрута)
+constexpr double kNetworkSvgWidth  = 1600.0;
+constexpr double kNetworkSvgHeight = 1200.0;
+
+// ADDED: строк на странице списка маршрутов/остановок (команды L B <page>, L S <page>)
+constexpr size_t kListPageSize = 50;
 #endif
 
 #ifdef INTERACTIVE
@@ -47,59 +72,17 @@ using transport_catalogue::render::RenderStopSvg;
 namespace detail {
 
 // =============================================================
-// Найти остановку, где сходятся 2 САМЫХ КОРОТКИХ маршрута
+// Консоль делят главный поток (команды) и фоновые задачи (рендер, список):
+// каждый кусок вывода печатается целиком под этим mutex
 // =============================================================
-static std::tuple<const Stop*, const Bus*, const Bus*, size_t>
-FindStopWithTwoShortestIntersectingBuses(const TransportCatalogue& cat) {
-    const auto& stops = cat.GetAllStops();
-
-    const Stop* best_stop = nullptr;
-    const Bus*  best_b1   = nullptr;
-    const Bus*  best_b2   = nullptr;
-    size_t best_score     = 0;
-
-    for (const Stop* stop : stops) {
-        const auto& buses_set = cat.GetBusesByStop(stop);
-
-        if (buses_set.size() < 2) {
-            continue;
-        }
-
-        const Bus* shortest1 = nullptr;
-        const Bus* shortest2 = nullptr;
-
-        for (const Bus* b : buses_set) {
-            const size_t len = b->stops.size();
-
-            if (!shortest1
-                || len < shortest1->stops.size()
-                || (len == shortest1->stops.size() && b->name < shortest1->name)) {
-                shortest2 = shortest1;
-                shortest1 = b;
-            } else if (!shortest2
-                       || len < shortest2->stops.size()
-                       || (len == shortest2->stops.size() && b->name < shortest2->name)) {
-                shortest2 = b;
-            }
-        }
-
-        if (!shortest1 || !shortest2) {
-            continue;
-        }
-
-        const size_t score = shortest1->stops.size() + shortest2->stops.size();
-
-        if (!best_stop
-            || score < best_score
-            || (score == best_score && stop->name < best_stop->name)) {
-            best_stop = stop;
-            best_b1 = shortest1;
-            best_b2 = shortest2;
-            best_score = score;
-        }
-    }
+static std::mutex& ConsoleMutex() {
+    static std::mutex m;
+    return m;
+}
 
-    return {best_stop, best_b1, best_b2, best_score};
+static void PrintLocked(const std::string& text) {
+    std::lock_guard lock(ConsoleMutex());
+    std::cout << text << std::flush;
 }
 
 // Вставляем строку "Score" в SVG
@@ -128,6 +111,29 @@ static std::string InjectSummaryIntoSvg(std::string svg, size_t score_sum) {
     return svg;
 }
 
+// =============================================================
+// Аргументы командной строки
+// =============================================================
+void PrintUsage(std::ostream& out) {
+    out << "Usage: transport_catalogue.exe [input.txt] [--export <dir>] [--stops]"
+           " [--threads <n>] [--compress-routes] [--hilbert] [--memory-report]\n";
+}
+
+// --threads: только десятичное число без знака (0 — по числу аппаратных потоков)
+std::optional<std::size_t> ParseThreadCount(std::string_view value) {
+    if (value.empty() || value.size() > 6) {
+        return std::nullopt;
+    }
+    std::size_t n = 0;
+    for (const char ch : value) {
+        if (!std::isdigit(static_cast<unsigned char>(ch))) {
+            return std::nullopt;
+        }
+        n = n * 10 + static_cast<std::size_t>(ch - '0');
+    }
+    return n;
+}
+
 } // namespace detail
 #endif
 
@@ -136,8 +142,47 @@ int main(int argc, char** argv) {
 
     istream* input = &cin;
     ifstream fin;
+    bool hilbert_reorder = false;
 
 #ifdef INTERACTIVE
+    // ADDED: пакетный экспорт без интерактива:
+    //   transport_catalogue.exe input.txt --export <dir> [--stops] [--threads <n>]
+    // --compress-routes: остановки маршрутов хранятся в delta+varint (для очень больших сетей)
+    // --hilbert: после загрузки переложить остановки в памяти вдоль кривой Гильберта
+    // --memory-report: загрузить, напечатать оценку памяти по структурам (CSV) и выйти —
+    //                  для сравнения раскладок бенчмарком
+    transport_catalogue::render::BatchExportOptions export_options;
+    bool batch_export = false;
+    bool memory_report = false;
+
+    for (int i = 2; i < argc; ++i) {
+        const string arg = argv[i];
+        if (arg == "--export" && i + 1 < argc) {
+            batch_export = true;
+            export_options.out_dir = argv[++i];
+        } else if (arg == "--stops") {
+            export_options.include_stops = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            const auto threads = detail::ParseThreadCount(argv[++i]);
+            if (!threads) {
+                cout << "Invalid --threads value: " << argv[i] << "\n";
+                detail::PrintUsage(cout);
+                return 1;
+            }
+            export_options.threads = *threads;
+        } else if (arg == "--compress-routes") {
+            catalogue.SetStopEncoding(transport_catalogue::domain::StopEncoding::kDeltaVarint);
+        } else if (arg == "--hilbert") {
+            hilbert_reorder = true;
+        } else if (arg == "--memory-report") {
+            memory_report = true;
+        } else {
+            cout << "Unknown argument: " << arg << "\n";
+            detail::PrintUsage(cout);
+            return 1;
+        }
+    }
+
     if (argc >= 2) {
         fin.open(argv[1]);
         if (!fin) {
@@ -161,6 +206,12 @@ int main(int argc, char** argv) {
         reader.ApplyCommands(catalogue);
     }
 
+    // ADDED: по запросу (--hilbert) каталог, загруженный целиком, раскладывает остановки
+    // в памяти вдоль кривой Гильберта
+    if (hilbert_reorder) {
+        catalogue.ReorderStopsAlongHilbertCurve();
+    }
+
 #ifndef INTERACTIVE
     int stat_request_count = 0;
     (*input) >> stat_request_count >> ws;
@@ -171,6 +222,28 @@ int main(int argc, char** argv) {
         ParseAndPrintStat(catalogue, line, cout);
     }
 #else
+    if (memory_report) {
+        transport_catalogue::stat::PrintMemoryUsageCsv(catalogue.MemoryUsage(), cout);
+        return 0;
+    }
+
+    if (batch_export) {
+        export_options.precision = kSvgPrecision;
+        export_options.compact = kSvgCompact;
+
+        const auto res = transport_catalogue::render::ExportAllSvgs(catalogue, export_options);
+        cout << "Exported to " << export_options.out_dir << ": "
+             << res.bus_files << " route SVGs, " << res.stop_files << " stop SVGs";
+        if (res.failed) {
+            cout << ", " << res.failed << " failed";
+        }
+        cout << "\n";
+        for (const auto& collision : res.collisions) {
+            cout << "  file name collision, renamed: " << collision << "\n";
+        }
+        return res.failed ? 1 : 0;
+    }
+
     const auto& buses = catalogue.GetAllBuses();
     const auto& stops = catalogue.GetAllStops();
 
@@ -180,54 +253,86 @@ int main(int argc, char** argv) {
         return 0;
     }
 
-    for (size_t i = 0; i < buses.size(); ++i) {
-        const Bus* bus = buses[i];
-        const auto stat = catalogue.GetBusStat(bus->name);
+    cout << "Found stops: " << stops.size() << "\n"
+         << "Use L B <page> / L S <page> to list them (" << kListPageSize << " per page).\n";
 
-        cout << (i + 1) << ") "
-             << "Bus " << bus->name << ": "
-             << stat.stops_count << " stops on route, "
-             << stat.unique_stops << " unique stops, "
-             << setprecision(6) << stat.route_length << " route length\n";
-    }
-
-    cout << "\nStops list: " << stops.size() << "\n\n";
-    for (size_t i = 0; i < stops.size(); ++i) {
-        const Stop* stop = stops[i];
-        const auto& buses_set = catalogue.GetBusesByStop(stop);
+    // ADDED: лучшее пересечение берётся из индекса каталога (O(1)); SVG для него — в фоне
+    transport_catalogue::util::ThreadPool startup_queue(1);
+    startup_queue.Submit([&catalogue] {
+        try {
+            ostringstream summary;
+            const auto& [st, b1, b2, score] = catalogue.GetShortestIntersection();
 
-        cout << (i + 1) << ") Stop " << stop->name
-             << " (" << buses_set.size() << " routes)\n";
-    }
+            if (!st) {
+                summary << "\nNo stop with >=2 routes found (no intersections).\n";
+            } else {
+                summary << "\n✅ Two shortest routes that intersect at one stop:\n";
+                summary << "Stop: " << st->name << "\n";
+                summary << "Bus " << b1->name << " (" << b1->stops.size() << " stops)\n";
+                summary << "Bus " << b2->name << " (" << b2->stops.size() << " stops)\n";
+                summary << "Score (sum): " << score << "\n";
 
-    {
-        auto [st, b1, b2, score] = detail::FindStopWithTwoShortestIntersectingBuses(catalogue);
+                vector<const Bus*> best_vec = {b1, b2};
 
-        if (!st) {
-            cout << "\nNo stop with >=2 routes found (no intersections).\n";
-        } else {
-            cout << "\n✅ Two shortest routes that intersect at one stop:\n";
-            cout << "Stop: " << st->name << "\n";
-            cout << "Bus " << b1->name << " (" << b1->stops.size() << " stops)\n";
-            cout << "Bus " << b2->name << " (" << b2->stops.size() << " stops)\n";
-            cout << "Score (sum): " << score << "\n";
+                sort(best_vec.begin(), best_vec.end(),
+                     [](const Bus* a, const Bus* b) { return a->name < b->name; });
 
-            vector<const Bus*> best_vec = {b1, b2};
+                string svg = RenderStopSvg(*st, best_vec);
+                svg = detail::InjectSummaryIntoSvg(std::move(svg), score);
 
-            sort(best_vec.begin(), best_vec.end(),
-                 [](const Bus* a, const Bus* b) { return a->name < b->name; });
+                const string filename = "best_intersection_stop.svg";
+                SvgWriter out;
+                out.Open(filename);
+                out << svg;
+                out.Close();
 
-            string svg = RenderStopSvg(*st, best_vec);
-            svg = detail::InjectSummaryIntoSvg(std::move(svg), score);
+                summary << "SVG saved to: " << filename << "\n";
+            }
+            detail::PrintLocked(summary.str());
+        } catch (const std::exception& e) {
+            detail::PrintLocked(string("\n[failed] best intersection: ") + e.what() + "\n");
+        } catch (...) {
+            detail::PrintLocked("\n[failed] best intersection: unknown error\n");
+        }
+    });
+
+    // ADDED: постраничные списки; BusStat считается только для показанной страницы
+    // (GetBusStat сам запоминает её в каталоге — одну на одинаковые маршруты)
+    auto PrintPage = [](const char* title, size_t page, size_t total, auto&& print_line) {
+        const size_t pages = (total + kListPageSize - 1) / kListPageSize;
+        if (page == 0 || page > pages) {
+            cout << title << ": no page " << page << " (pages 1.." << pages << ")\n";
+            return;
+        }
+        const size_t first = (page - 1) * kListPageSize;
+        const size_t last = min(total, first + kListPageSize);
+        cout << title << ", page " << page << "/" << pages
+             << " (" << (first + 1) << ".." << last << " of " << total << "):\n";
+        for (size_t i = first; i < last; ++i) {
+            print_line(i);
+        }
+    };
 
-            const string filename = "best_intersection_stop.svg";
-            ofstream out(filename);
-            out << svg;
-            out.close();
+    auto ListBuses = [&](size_t page) {
+        PrintPage("Routes", page, buses.size(), [&](size_t i) {
+            const Bus* bus = buses[i];
+            const BusStat stat = catalogue.GetBusStat(bus->name);
+
+            cout << (i + 1) << ") "
+                 << "Bus " << bus->name << ": "
+                 << stat.stops_count << " stops on route, "
+                 << stat.unique_stops << " unique stops, "
+                 << setprecision(6) << stat.route_length << " route length\n";
+        });
+    };
 
-            cout << "SVG saved to: " << filename << "\n";
-        }
-    }
+    auto ListStops = [&](size_t page) {
+        PrintPage("Stops", page, stops.size(), [&](size_t i) {
+            const Stop* stop = stops[i];
+            cout << (i + 1) << ") Stop " << stop->name
+                 << " (" << catalogue.GetBusSpanByStop(stop).size() << " routes)\n";
+        });
+    };
 
     auto Trim = [](string s) {
         while (!s.empty() && isspace(static_cast<unsigned char>(s.front()))) {
@@ -239,32 +344,134 @@ int main(int argc, char** argv) {
         return s;
     };
 
-    auto MakeSafeFilename = [](string s) {
-        for (char& ch : s) {
-            if (ch == ' ') ch = '_';
+    // один буфер на все SVG сессии (переиспользуется между файлами;
+    // им пользуется только поток очереди рендера)
+    SvgWriter svg_out(kSvgPrecision);
+    svg_out.SetCompact(kSvgCompact);
+
+    auto SaveSvg = [&svg_out](const string& filename, auto&& render, ostream& log) {
+        if (!svg_out.Open(filename)) {
+            log << "Cannot write file: " << filename << "\n";
+            return;
         }
-        return s;
+        render(svg_out);
+        if (!svg_out.Close()) {
+            log << "Write error: " << filename << "\n";
+            return;
+        }
+        log << "SVG saved to: " << filename << "\n";
+        log << "Open it with a browser.\n";
+    };
+
+    // повторные рендеры одного и того же маршрута/остановки берутся из кеша
+    RenderCache render_cache;
+
+    auto SaveCachedSvg = [&SaveSvg](const string& filename, const CachedSvg& cached, ostream& log) {
+        SaveSvg(filename, [&cached](SvgWriter& out) { out << cached.svg->bytes; }, log);
+        log << "SVG hash: " << hex << setw(16) << setfill('0') << cached.svg->hash
+            << dec << setfill(' ') << (cached.hit ? " (from render cache)" : "") << "\n";
+    };
+
+    // ADDED: фоновая очередь рендера — команда ставит задачу и сразу возвращает приглашение.
+    // Один поток: задачи идут по порядку, два рендера одного файла не пересекаются.
+    // Объявлена ПОСЛЕ всего, что задачи используют по ссылке: разрушается первой (дожидаясь задач).
+    transport_catalogue::util::ThreadPool render_queue(1);
+
+    auto Enqueue = [&render_queue](const string& what, auto job) {
+        render_queue.Submit([what, job = std::move(job)] {
+            // исключение не должно выйти из задачи пула (иначе std::terminate) — сообщаем о нём
+            try {
+                ostringstream log;
+                log << "\n[done] " << what << "\n";
+                job(log);
+                detail::PrintLocked(log.str());
+            } catch (const std::exception& e) {
+                detail::PrintLocked("\n[failed] " + what + ": " + e.what() + "\n");
+            } catch (...) {
+                detail::PrintLocked("\n[failed] " + what + ": unknown error\n");
+            }
+        });
+        cout << "Queued: " << what << "\n";
+    };
+
+    auto EnqueueBus = [&](const Bus* bus) {
+        const string filename = "bus_" + MakeSafeFilename(bus->name) + ".svg";
+        Enqueue(filename, [&, bus, filename](ostream& log) {
+            SaveCachedSvg(filename,
+                          render_cache.GetBus(catalogue, *bus, 800.0, 600.0, 50.0,
+                                              kSvgPrecision, kSvgCompact),
+                          log);
+        });
     };
 
     while (true) {
-        cout << "\nCommands:\n"
-             << "  B <number>  - render route by index (e.g. B 1)\n"
-             << "  S <number>  - render stop  by index with all its routes (e.g. S 3)\n"
-             << "  <bus_name>  - render route by name (e.g. 256)\n"
-             << "  Q           - exit\n"
-             << "Enter command: ";
+        {
+            lock_guard lock(detail::ConsoleMutex());
+            cout << "\nCommands:\n"
+                 << "  L B <page>  - list routes with stats, page by page (e.g. L B 1)\n"
+                 << "  L S <page>  - list stops with route counts (e.g. L S 1)\n"
+                 << "  B <number>  - render route by index (e.g. B 1)\n"
+                 << "  S <number>  - render stop  by index with all its routes (e.g. S 3)\n"
+                 << "  <bus_name>  - render route by name (e.g. 256)\n"
+                 << "  N           - render the whole network (all routes and stops)\n"
+                 << "  T <zoom>    - export network tile pyramid 0..zoom to tiles/ (e.g. T 3)\n"
+                 << "  M           - memory usage estimate per catalogue structure\n"
+                 << "  Q           - exit\n"
+                 << "(renders run in the background; results are printed when ready)\n"
+                 << "Enter command: " << flush;
+        }
 
         string line;
-        getline(cin >> ws, line);
+        if (!getline(cin >> ws, line)) {
+            break;
+        }
         line = Trim(line);
 
+        // команды только ставят задачи — под mutex вывод не перемешается с фоновым
+        lock_guard lock(detail::ConsoleMutex());
+
         if (line == "Q" || line == "q") {
-            cout << "Bye!\n";
             break;
         }
 
+        if (line == "N" || line == "n") {
+            Enqueue("network.svg", [&](ostream& log) {
+                SaveSvg("network.svg", [&catalogue](SvgWriter& out) {
+                    RenderNetworkSvg(out, catalogue, kNetworkSvgWidth, kNetworkSvgHeight);
+                }, log);
+            });
+            continue;
+        }
+
+        if (line == "M" || line == "m") {
+            PrintMemoryUsage(catalogue.MemoryUsage(), cout);
+            continue;
+        }
+
+        if (line.size() >= 2 && (line[0] == 'L' || line[0] == 'l')
+            && isspace(static_cast<unsigned char>(line[1]))) {
+            istringstream args(line.substr(1));
+            char what = 0;
+            size_t page = 1;
+            args >> what;
+            if (!(args >> page)) {
+                page = 1;
+            }
+
+            what = static_cast<char>(toupper(static_cast<unsigned char>(what)));
+            if (what == 'B') {
+                ListBuses(page);
+            } else if (what == 'S') {
+                ListStops(page);
+            } else {
+                cout << "Usage: L B <page> | L S <page>\n";
+            }
+            continue;
+        }
+
         if (line.size() >= 2 &&
-            (line[0] == 'B' || line[0] == 'b' || line[0] == 'S' || line[0] == 's') &&
+            (line[0] == 'B' || line[0] == 'b' || line[0] == 'S' || line[0] == 's'
+             || line[0] == 'T' || line[0] == 't') &&
             isspace(static_cast<unsigned char>(line[1]))) {
 
             char cmd = static_cast<char>(toupper(static_cast<unsigned char>(line[0])));
@@ -278,6 +485,25 @@ int main(int argc, char** argv) {
                 continue;
             }
 
+            if (cmd == 'T') {
+                transport_catalogue::render::TileExportOptions options;
+                options.out_dir = "tiles";
+                options.max_zoom = static_cast<int>(idx);
+                options.precision = kSvgPrecision;
+                options.compact = kSvgCompact;
+
+                Enqueue("tiles 0.." + to_string(idx), [&catalogue, options](ostream& log) {
+                    const auto res = transport_catalogue::render::ExportTilePyramid(catalogue, options);
+                    log << "Tiles saved to: " << options.out_dir << "/<z>/<x>/<y>.svg ("
+                        << res.tiles_written << " written, " << res.tiles_empty << " empty skipped";
+                    if (res.tiles_failed) {
+                        log << ", " << res.tiles_failed << " failed";
+                    }
+                    log << ")\n";
+                });
+                continue;
+            }
+
             if (cmd == 'B') {
                 const Bus* bus = catalogue.GetBusByIndex(idx);
                 if (!bus) {
@@ -285,13 +511,7 @@ int main(int argc, char** argv) {
                     continue;
                 }
 
-                const string filename = "bus_" + MakeSafeFilename(bus->name) + ".svg";
-                ofstream out(filename);
-                out << RenderBusSvg(*bus);
-                out.close();
-
-                cout << "SVG saved to: " << filename << "\n";
-                cout << "Open it with a browser.\n";
+                EnqueueBus(bus);
                 continue;
             }
 
@@ -302,7 +522,7 @@ int main(int argc, char** argv) {
                     continue;
                 }
 
-                const auto& buses_set = catalogue.GetBusesByStop(stop);
+                const auto buses_set = catalogue.GetBusSpanByStop(stop);
                 if (buses_set.empty()) {
                     cout << "Stop " << stop->name << ": no buses\n";
                     continue;
@@ -312,21 +532,13 @@ int main(int argc, char** argv) {
                 sort(buses_vec.begin(), buses_vec.end(),
                      [](const Bus* a, const Bus* b) { return a->name < b->name; });
 
-                constexpr size_t kMaxRoutesInStopSvg = 2;
-                if (buses_vec.size() > kMaxRoutesInStopSvg) {
-                    cout << "Stop " << stop->name << ": showing only first "
-                         << kMaxRoutesInStopSvg << " routes out of " << buses_vec.size()
-                         << " in SVG\n";
-                    buses_vec.resize(kMaxRoutesInStopSvg);
-                }
-
                 const string filename = "stop_" + MakeSafeFilename(stop->name) + ".svg";
-                ofstream out(filename);
-                out << RenderStopSvg(*stop, buses_vec);
-                out.close();
-
-                cout << "SVG saved to: " << filename << "\n";
-                cout << "Open it with a browser.\n";
+                Enqueue(filename, [&, stop, filename, buses_vec = std::move(buses_vec)](ostream& log) {
+                    SaveCachedSvg(filename,
+                                  render_cache.GetStop(catalogue, *stop, buses_vec, 800.0, 600.0, 50.0,
+                                                       kSvgPrecision, kSvgCompact),
+                                  log);
+                });
                 continue;
             }
         }
@@ -337,14 +549,13 @@ int main(int argc, char** argv) {
             continue;
         }
 
-        const string filename = "bus_" + MakeSafeFilename(bus->name) + ".svg";
-        ofstream out(filename);
-        out << RenderBusSvg(*bus);
-        out.close();
-
-        cout << "SVG saved to: " << filename << "\n";
-        cout << "Open it with a browser.\n";
+        EnqueueBus(bus);
     }
+
+    // Q / конец ввода: недоделанные задачи дорабатывают до выхода
+    render_queue.Wait();
+    startup_queue.Wait();
+    cout << "Bye!\n";
 #endif
 
     return 0;
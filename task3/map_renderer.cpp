@@ -1,22 +1,34 @@
 // map_renderer.cpp
 #include "map_renderer.h"
 
+#include "thread_pool.h"
+
 /**************************************************************************************************
  * Неймспейсы:
  * - transport_catalogue::render         — публичные функции (RenderBusSvg / RenderStopSvg)
- * - transport_catalogue::render::detail — внутренняя кухня (Point, Projector, helpers)
+ * - transport_catalogue::render::detail — внутренняя кухня (Projector, helpers)
  *
  * Исправления:
  * - Добавлены DrawStops + DrawHeader (уменьшает дублирование)
  * - top_margin динамический в RenderStopSvg (шапка не липнет, снизу не режется)
  * - увеличен развод двухсторонних линий (two-way), чтобы "туда/обратно" не слипались
+ * - вывод через SvgWriter (svg_writer.h) вместо std::ostringstream:
+ *   элементы пишутся сразу в буфер/файл, числа — быстрым форматтером
+ * - RenderContext: остановки проецируются один раз на viewport, рендеры берут готовые точки
+ * - ExportTilePyramid: сеть режется на тайлы z/x/y.svg и рендерится параллельно (ThreadPool)
+ * - ExportAllSvgs: все маршруты/остановки в отдельные файлы, тоже в пуле потоков
+ * - PlaceLabels: подписи остановок без наложений (сетка занятости), лишние не выводятся
  **************************************************************************************************/
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
-#include <iomanip>
-#include <sstream>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <limits>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -30,11 +42,6 @@ using transport_catalogue::domain::Stop;
 using transport_catalogue::domain::Bus;
 using transport_catalogue::geo::Coordinates;
 
-struct Point {
-    double x = 0.0;
-    double y = 0.0;
-};
-
 class SphereProjector {
 public:
     SphereProjector(const std::vector<Coordinates>& coords,
@@ -52,15 +59,21 @@ public:
             max_lat_ = std::max(max_lat_, c.lat);
         }
 
-        const double usable_w = width - 2 * padding_;
-        const double usable_h = height - 2 * padding_;
+        SetZoom(width, height);
+    }
 
-        const double zx = (max_lng_ - min_lng_ != 0.0) ? usable_w / (max_lng_ - min_lng_) : 0.0;
-        const double zy = (max_lat_ - min_lat_ != 0.0) ? usable_h / (max_lat_ - min_lat_) : 0.0;
+    // bbox уже посчитан (geo::BoundingBox)
+    SphereProjector(const transport_catalogue::geo::BoundingBox& box,
+                    double width, double height, double padding)
+        : padding_(padding) {
+        if (box.empty) return;
 
-        if (zx == 0.0) zoom_ = zy;
-        else if (zy == 0.0) zoom_ = zx;
-        else zoom_ = std::min(zx, zy);
+        min_lng_ = box.min.lng;
+        max_lng_ = box.max.lng;
+        min_lat_ = box.min.lat;
+        max_lat_ = box.max.lat;
+
+        SetZoom(width, height);
     }
 
     Point operator()(Coordinates c) const {
@@ -71,6 +84,18 @@ public:
     }
 
 private:
+    void SetZoom(double width, double height) {
+        const double usable_w = width - 2 * padding_;
+        const double usable_h = height - 2 * padding_;
+
+        const double zx = (max_lng_ - min_lng_ != 0.0) ? usable_w / (max_lng_ - min_lng_) : 0.0;
+        const double zy = (max_lat_ - min_lat_ != 0.0) ? usable_h / (max_lat_ - min_lat_) : 0.0;
+
+        if (zx == 0.0) zoom_ = zy;
+        else if (zy == 0.0) zoom_ = zx;
+        else zoom_ = std::min(zx, zy);
+    }
+
     double padding_;
     double min_lng_ = 0.0, max_lng_ = 0.0;
     double min_lat_ = 0.0, max_lat_ = 0.0;
@@ -97,29 +122,18 @@ static const char* EmojiFont() {
     return "Segoe UI Emoji, Apple Color Emoji, Noto Color Emoji, sans-serif";
 }
 
-static std::string DirEmoji(Point a, Point b) {
+// Направление a->b: 0 — вправо, 1 — влево, 2 — вверх, 3 — вниз (индекс в kDirEmoji)
+static int DirIndex(Point a, Point b) {
     const double dx = b.x - a.x;
     const double dy = b.y - a.y;
 
     if (std::fabs(dx) >= std::fabs(dy)) {
-        return (dx >= 0) ? u8"👉" : u8"👈";
+        return (dx >= 0) ? 0 : 1;
     }
-    return (dy <= 0) ? u8"👆" : u8"👇";
+    return (dy <= 0) ? 2 : 3;
 }
 
-struct EdgeKey {
-    const Stop* from = nullptr;
-    const Stop* to = nullptr;
-    bool operator==(const EdgeKey& o) const noexcept { return from == o.from && to == o.to; }
-};
-
-struct EdgeKeyHasher {
-    size_t operator()(const EdgeKey& k) const noexcept {
-        auto h1 = std::hash<const void*>{}(k.from);
-        auto h2 = std::hash<const void*>{}(k.to);
-        return h1 * 37u + h2;
-    }
-};
+static const char* const kDirEmoji[4] = {u8"👉", u8"👈", u8"👆", u8"👇"};
 
 static const std::vector<std::string>& ColorPalette() {
     static const std::vector<std::string> p = {
@@ -128,6 +142,10 @@ static const std::vector<std::string>& ColorPalette() {
     return p;
 }
 
+// LOD по умолчанию: полпикселя — невидимое отклонение; 18 px — размер эмодзи-маркера
+constexpr double kLodTolerancePx  = 0.5;
+constexpr double kMarkerSpacingPx = 18.0;
+
 /**************************************************************************************************
  * RouteDrawStyle — единый набор параметров рисования маршрута
  **************************************************************************************************/
@@ -143,49 +161,258 @@ struct RouteDrawStyle {
     double offset_twoway = 10.0;
     double dt_twoway     = 0.10;
 
-    // внешний сдвиг (например для stop-map: раздвигаем маршруты между собой)
-    Point extra_shift{0.0, 0.0};
+    // полосы (stop-map): сдвиг в px для каждого исходного сегмента маршрута вдоль
+    // перпендикуляра КАНОНИЧЕСКОГО направления (id меньше -> id больше); у каждого
+    // направления своя полоса, поэтому отдельный two-way сдвиг не нужен (см. AssignLanes)
+    const std::vector<double>* lane_offsets = nullptr;
+
+    // LOD (level of detail): размер вывода ограничен тем, что видно на холсте
+    // - simplify_tolerance: Douglas–Peucker по спроецированным точкам, px (0 — выключено)
+    // - marker_spacing:     эмодзи 🚌/👉 ставятся не чаще, чем раз в столько px пути
+    //                       (маркеры на под-пиксельных сегментах всё равно слились бы)
+    double simplify_tolerance = kLodTolerancePx;
+    double marker_spacing     = kMarkerSpacingPx;
+};
+
+/**************************************************************************************************
+ * Компактный режим (SvgWriter::IsCompact)
+ *
+ * - WriteSvgDefs: <style> с классами + <defs> с эмодзи-маркерами и значками остановок,
+ *                 которые дальше ставятся через <use href="#id" x y/>
+ * - RelativePath: все сегменты одного цвета — один <path>; первая точка абсолютная (M),
+ *                 дальше относительные l/m от УЖЕ ОКРУГЛЁННОГО пера (ошибка не копится)
+ **************************************************************************************************/
+static void WriteSvgDefs(SvgWriter& svg) {
+    svg << "  <style>.r{fill:none;stroke-linecap:round;stroke-linejoin:round}"
+        << ".e,.s{font-family:" << EmojiFont() << "}.e{font-size:18px}.s{font-size:16px}"
+        << ".n{font-size:14px;font-family:Verdana}</style>\n";
+
+    svg << "  <defs>\n";
+    svg << "    <text id=\"b\" class=\"e\">" << u8"🚌" << "</text>\n";
+    for (int d = 0; d < 4; ++d) {
+        svg << "    <text id=\"a" << d << "\" class=\"e\">" << kDirEmoji[d] << "</text>\n";
+    }
+
+    // значки остановок: обычная (sw), на карте маршрута (sy), выделенная (sh) — см. DrawStops
+    struct StopMark { const char* id; int r; const char* fill; const char* stroke; int sw; };
+    static const StopMark kMarks[] = {
+        {"sw", 5, "white", "black", 2}, {"sy", 6, "yellow", "black", 2}, {"sh", 9, "yellow", "red", 3}
+    };
+    for (const StopMark& m : kMarks) {
+        svg << "    <g id=\"" << m.id << "\"><circle r=\"" << m.r << "\" fill=\"" << m.fill
+            << "\" stroke=\"" << m.stroke << "\" stroke-width=\"" << m.sw
+            << "\" /><text class=\"s\" x=\"10\" y=\"6\">" << u8"🚏" << "</text></g>\n";
+    }
+    svg << "  </defs>\n";
+}
+
+static void WriteUse(SvgWriter& svg, std::string_view id, Point p) {
+    svg << "  <use href=\"#" << id << "\" x=\"" << p.x << "\" y=\"" << p.y << "\" />\n";
+}
+
+class RelativePath {
+public:
+    RelativePath(SvgWriter& svg, std::string_view color, double stroke_width)
+        : svg_(svg), color_(color), stroke_width_(stroke_width) {}
+
+    void Segment(Point a, Point b) {
+        a = Rounded(a);
+        b = Rounded(b);
+        if (!open_) {
+            svg_ << "  <path class=\"r\" stroke=\"" << color_
+                 << "\" stroke-width=\"" << stroke_width_ << "\" d=\"M";
+            WritePair(a);
+            open_ = true;
+        } else if (a.x != pen_.x || a.y != pen_.y) {
+            svg_ << 'm';
+            WritePair({a.x - pen_.x, a.y - pen_.y});
+        }
+        svg_ << 'l';
+        WritePair({b.x - a.x, b.y - a.y});
+        pen_ = b;
+    }
+
+    // закрывает <path>, если был хотя бы один сегмент
+    void Finish() {
+        if (open_) {
+            svg_ << "\" />\n";
+            open_ = false;
+        }
+    }
+
+private:
+    Point Rounded(Point p) const { return {svg_.Round(p.x), svg_.Round(p.y)}; }
+
+    // "x,y"; перед отрицательным y запятая не нужна
+    void WritePair(Point d) {
+        svg_ << d.x;
+        if (!std::signbit(d.y)) svg_ << ',';
+        svg_ << d.y;
+    }
+
+    SvgWriter& svg_;
+    std::string_view color_;
+    double stroke_width_;
+    bool open_ = false;
+    Point pen_;
 };
 
+/**************************************************************************************************
+ * SimplifyPolyline — Douglas–Peucker: индексы точек, которые остаются после упрощения
+ *
+ * - первая и последняя точки остаются всегда, как и точки с fixed[i] == true:
+ *   упрощение идёт независимо на каждом участке между ними (через них не склеивается)
+ * - точка удаляется, если она ближе tolerance px к хорде упрощённого участка
+ * - tolerance <= 0 -> все индексы (LOD выключен)
+ * - итеративно (свой стек), без рекурсии: длинные маршруты не переполнят стек вызовов
+ **************************************************************************************************/
+static double DistToSegment(Point p, Point a, Point b) {
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const double len2 = dx * dx + dy * dy;
+    double t = 0.0;
+    if (len2 > 0.0) {
+        t = std::clamp(((p.x - a.x) * dx + (p.y - a.y) * dy) / len2, 0.0, 1.0);
+    }
+    const double ex = a.x + dx * t - p.x;
+    const double ey = a.y + dy * t - p.y;
+    return std::sqrt(ex * ex + ey * ey);
+}
+
+static std::vector<std::size_t> SimplifyPolyline(const std::vector<Point>& pts, double tolerance,
+                                                 const std::vector<bool>& fixed) {
+    std::vector<std::size_t> keep;
+    if (tolerance <= 0.0 || pts.size() <= 2) {
+        keep.resize(pts.size());
+        for (std::size_t i = 0; i < pts.size(); ++i) keep[i] = i;
+        return keep;
+    }
+
+    std::vector<bool> kept = fixed;
+    kept.front() = kept.back() = true;
+
+    std::vector<std::pair<std::size_t, std::size_t>> stack;
+    for (std::size_t first = 0, i = 1; i < pts.size(); ++i) {
+        if (kept[i]) {
+            stack.emplace_back(first, i);
+            first = i;
+        }
+    }
+
+    while (!stack.empty()) {
+        const auto [first, last] = stack.back();
+        stack.pop_back();
+
+        double max_dist = tolerance;
+        std::size_t farthest = first;
+        for (std::size_t i = first + 1; i < last; ++i) {
+            const double d = DistToSegment(pts[i], pts[first], pts[last]);
+            if (d > max_dist) {
+                max_dist = d;
+                farthest = i;
+            }
+        }
+
+        if (farthest != first) {
+            kept[farthest] = true;
+            stack.emplace_back(first, farthest);
+            stack.emplace_back(farthest, last);
+        }
+    }
+
+    for (std::size_t i = 0; i < pts.size(); ++i) {
+        if (kept[i]) keep.push_back(i);
+    }
+    return keep;
+}
+
 /**************************************************************************************************
  * DrawBusSegments — единая реализация сегментов + эмодзи
+ *
+ * pts[i] — уже спроецированная точка bus.stops[i] (с учётом top_margin):
+ * каждая остановка проецируется один раз на посещение, а не дважды на сегмент.
+ *
+ * LOD: рисуются только сегменты между точками, пережившими SimplifyPolyline.
+ * Склеиваются лишь сегменты с одинаковым видом (SegmentLook: two-way, направление, полоса):
+ * на границах вида точки закреплены, поэтому склеенный сегмент рисуется как любой свой исходный.
  **************************************************************************************************/
-static void DrawBusSegments(std::ostringstream& svg,
+struct SegmentDraw {
+    Point a, b;            // концы линии (сдвиги уже применены)
+    bool marker = false;   // ставить ли эмодзи на этом сегменте
+    Point arrow, bus;
+    int dir = 0;           // индекс в kDirEmoji
+};
+
+// То, от чего зависит вид сегмента seg: сдвиг линии и положение эмодзи.
+// - lane: сдвиг полосы вдоль перпендикуляра направления ДВИЖЕНИЯ (знак направления уже учтён)
+// - canonical: важен только для two-way (сдвиг и эмодзи), у остальных всегда true
+struct SegmentLook {
+    bool two_way = false;
+    bool canonical = true;
+    double lane = 0.0;
+
+    bool operator==(const SegmentLook& other) const {
+        return two_way == other.two_way && canonical == other.canonical && lane == other.lane;
+    }
+    bool operator!=(const SegmentLook& other) const { return !(*this == other); }
+};
+
+static SegmentLook GetSegmentLook(const Bus& bus, std::size_t seg, const RouteDrawStyle& st) {
+    SegmentLook look;
+    look.two_way = bus.route->segments.IsTwoWay(seg);
+    const bool canonical = bus.route->segments.IsCanonical(seg);
+    if (look.two_way) {
+        look.canonical = canonical;
+    }
+    if (st.lane_offsets) {
+        look.lane = (*st.lane_offsets)[seg] * (canonical ? 1.0 : -1.0);
+    }
+    return look;
+}
+
+static void DrawBusSegments(SvgWriter& svg,
                             const Bus& bus,
-                            const SphereProjector& proj,
-                            double top_margin,
+                            const std::vector<Point>& pts,
                             const RouteDrawStyle& st) {
     if (bus.stops.size() < 2) return;
 
-    std::unordered_map<EdgeKey, int, EdgeKeyHasher> edges;
-    edges.reserve(bus.stops.size() * 2);
-
-    for (size_t i = 1; i < bus.stops.size(); ++i) {
-        ++edges[{bus.stops[i - 1], bus.stops[i]}];
+    // точка на смене вида сегментов закреплена: LOD не склеит через неё разные полосы/two-way
+    std::vector<bool> fixed(pts.size(), false);
+    if (st.simplify_tolerance > 0.0) {
+        SegmentLook prev = GetSegmentLook(bus, 0, st);
+        for (std::size_t seg = 1; seg + 1 < pts.size(); ++seg) {
+            const SegmentLook cur = GetSegmentLook(bus, seg, st);
+            fixed[seg] = (cur != prev);
+            prev = cur;
+        }
     }
+    const std::vector<std::size_t> keep = SimplifyPolyline(pts, st.simplify_tolerance, fixed);
 
-    for (size_t i = 1; i < bus.stops.size(); ++i) {
-        const Stop* from = bus.stops[i - 1];
-        const Stop* to   = bus.stops[i];
+    std::vector<SegmentDraw> draws;
+    draws.reserve(keep.size());
 
-        Point a = proj(from->coord);
-        Point b = proj(to->coord);
-        a.y += top_margin;
-        b.y += top_margin;
+    double since_marker = 0.0;  // px пути с последней пары эмодзи
 
-        const Point perp = ShiftPerp(a, b, 1.0);
+    for (size_t k = 1; k < keep.size(); ++k) {
+        const size_t i0 = keep[k - 1];
+        const size_t i1 = keep[k];
+
+        const Point a = pts[i0];
+        const Point b = pts[i1];
 
-        // two-way?
-        const bool two_way = edges.find({to, from}) != edges.end();
+        const Point perp = ShiftPerp(a, b, 1.0);
 
-        // каноническое направление по указателям
-        const Stop* lo = std::min(from, to);
-        const Stop* hi = std::max(from, to);
-        const bool canonical = (from == lo && to == hi);
+        // two-way / каноническое направление — посчитаны при загрузке (Route::segments);
+        // у всех исходных сегментов внутри [i0, i1) вид одинаковый — берём первый
+        const SegmentLook look = GetSegmentLook(bus, i0, st);
+        const bool two_way = look.two_way;
+        const bool canonical = look.canonical;
 
-        Point shift = st.extra_shift;
+        Point shift{0.0, 0.0};
 
-        if (two_way && !canonical) {
+        if (st.lane_offsets) {
+            shift = {perp.x * look.lane, perp.y * look.lane};
+        } else if (two_way && !canonical) {
             // 🔥 Разводим сильнее: базовый offset + зависимость от толщины линии
             const double tw = st.offset_twoway + st.stroke_width * 1.5;
             const Point tw_shift = ShiftPerp(a, b, tw);
@@ -193,12 +420,16 @@ static void DrawBusSegments(std::ostringstream& svg,
             shift.y += tw_shift.y;
         }
 
-        // линия
-        svg << "  <line x1=\"" << a.x + shift.x << "\" y1=\"" << a.y + shift.y
-            << "\" x2=\"" << b.x + shift.x << "\" y2=\"" << b.y + shift.y
-            << "\" stroke=\"" << st.stroke_color
-            << "\" stroke-width=\"" << st.stroke_width
-            << "\" stroke-linecap=\"round\" stroke-linejoin=\"round\" />\n";
+        SegmentDraw& d = draws.emplace_back();
+        d.a = {a.x + shift.x, a.y + shift.y};
+        d.b = {b.x + shift.x, b.y + shift.y};
+
+        // прореживание эмодзи: маркер — только когда набралось marker_spacing px пути
+        since_marker += std::hypot(b.x - a.x, b.y - a.y);
+        if (since_marker < st.marker_spacing) {
+            continue;
+        }
+        since_marker = 0.0;
 
         // точки для эмодзи
         double at = st.arrow_along;
@@ -214,78 +445,349 @@ static void DrawBusSegments(std::ostringstream& svg,
             }
         }
 
-        Point arrow = Lerp(a, b, at);
-        Point buspt = Lerp(a, b, bt);
+        d.marker = true;
+        d.dir = DirIndex(a, b);
+
+        d.arrow = Lerp(a, b, at);
+        d.bus = Lerp(a, b, bt);
+
+        d.arrow.x += shift.x - perp.x * st.emoji_sep;
+        d.arrow.y += shift.y - perp.y * st.emoji_sep;
+
+        d.bus.x += shift.x + perp.x * st.emoji_sep;
+        d.bus.y += shift.y + perp.y * st.emoji_sep;
+    }
+
+    if (svg.IsCompact()) {
+        // весь маршрут — один <path>, эмодзи — ссылки на <defs>
+        RelativePath path(svg, st.stroke_color, st.stroke_width);
+        for (const SegmentDraw& d : draws) {
+            path.Segment(d.a, d.b);
+        }
+        path.Finish();
+
+        static const char* const kArrowIds[4] = {"a0", "a1", "a2", "a3"};
+        for (const SegmentDraw& d : draws) {
+            if (!d.marker) continue;
+            WriteUse(svg, kArrowIds[d.dir], d.arrow);
+            WriteUse(svg, "b", d.bus);
+        }
+        return;
+    }
 
-        arrow.x += shift.x - perp.x * st.emoji_sep;
-        arrow.y += shift.y - perp.y * st.emoji_sep;
+    for (const SegmentDraw& d : draws) {
+        // линия
+        svg << "  <line x1=\"" << d.a.x << "\" y1=\"" << d.a.y
+            << "\" x2=\"" << d.b.x << "\" y2=\"" << d.b.y
+            << "\" stroke=\"" << st.stroke_color
+            << "\" stroke-width=\"" << st.stroke_width
+            << "\" stroke-linecap=\"round\" stroke-linejoin=\"round\" />\n";
 
-        buspt.x += shift.x + perp.x * st.emoji_sep;
-        buspt.y += shift.y + perp.y * st.emoji_sep;
+        if (!d.marker) continue;
 
-        svg << "  <text x=\"" << arrow.x << "\" y=\"" << arrow.y
+        svg << "  <text x=\"" << d.arrow.x << "\" y=\"" << d.arrow.y
             << "\" font-size=\"18\" font-family=\"" << EmojiFont() << "\">"
-            << DirEmoji(a, b) << "</text>\n";
+            << kDirEmoji[d.dir] << "</text>\n";
 
-        svg << "  <text x=\"" << buspt.x << "\" y=\"" << buspt.y
+        svg << "  <text x=\"" << d.bus.x << "\" y=\"" << d.bus.y
             << "\" font-size=\"18\" font-family=\"" << EmojiFont() << "\">"
             << u8"🚌" << "</text>\n";
     }
 }
 
 /**************************************************************************************************
- * DrawBusOnStopMap — рисует маршрут на карте остановки (цвет + развод маршрутов)
+ * AssignLanes — полосы маршрутов на карте остановки
+ *
+ * Для каждого неориентированного сегмента (пара Stop::id) считается, сколько (маршрут, направление)
+ * по нему идут; каждому достаётся свой номер полосы в порядке появления, а пучок центрируется
+ * на оси сегмента. Повторный проход того же маршрута в ту же сторону берёт ту же полосу.
+ *
+ * Один проход по всем сегментам всех маршрутов + хеш-таблицы: O(суммы длин маршрутов).
+ * Ширина полосы общая для карты: весь самый толстый пучок укладывается в kMaxBundleWidth.
  **************************************************************************************************/
-static void DrawBusOnStopMap(std::ostringstream& svg,
-                             const Bus& bus,
-                             const SphereProjector& proj,
-                             const std::string& color,
-                             double top_margin,
-                             double offset_index) {
-    if (bus.stops.size() < 2) return;
+constexpr double kLaneWidth      = 6.0;
+constexpr double kMinLaneWidth   = 1.5;
+constexpr double kMaxBundleWidth = 60.0;
+constexpr double kStopMapStroke  = 4.0;
+constexpr std::size_t kStopMapMarkerRoutes = 4;  // больше маршрутов — без эмодзи (не читаются)
+
+struct StopMapLanes {
+    std::vector<std::vector<double>> offsets;  // [маршрут][сегмент] -> px (см. RouteDrawStyle)
+    double lane_width = kLaneWidth;
+};
 
-    const double BASE_OFFSET = 3.5;
-
-    // найдём perp по первому ненулевому сегменту
-    Point perp{0.0, 0.0};
-    for (size_t i = 1; i < bus.stops.size(); ++i) {
-        Point a = proj(bus.stops[i - 1]->coord);
-        Point b = proj(bus.stops[i]->coord);
-        a.y += top_margin;
-        b.y += top_margin;
-        const Point p = ShiftPerp(a, b, 1.0);
-        if (p.x != 0.0 || p.y != 0.0) {
-            perp = p;
-            break;
+static std::uint64_t SegmentKey(std::uint32_t a, std::uint32_t b) {
+    return (static_cast<std::uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+}
+
+static StopMapLanes AssignLanes(const std::vector<const Bus*>& buses) {
+    struct LaneKey {
+        std::uint64_t segment;
+        std::uint32_t owner;  // маршрут * 2 + (направление неканоническое)
+        bool operator==(const LaneKey& o) const { return segment == o.segment && owner == o.owner; }
+    };
+    struct LaneKeyHasher {
+        std::size_t operator()(const LaneKey& k) const noexcept {
+            return std::hash<std::uint64_t>{}(k.segment * 0x9e3779b97f4a7c15ULL ^ k.owner);
+        }
+    };
+
+    std::size_t total = 0;
+    for (const Bus* b : buses) total += b->stops.size();
+
+    std::unordered_map<std::uint64_t, std::uint32_t> lanes_on_segment;
+    std::unordered_map<LaneKey, std::uint32_t, LaneKeyHasher> lane_of;
+    lanes_on_segment.reserve(total);
+    lane_of.reserve(total);
+
+    StopMapLanes result;
+    result.offsets.resize(buses.size());
+
+    // проход 1: номер полосы для каждого сегмента
+    for (std::size_t bi = 0; bi < buses.size(); ++bi) {
+        const Bus& bus = *buses[bi];
+        std::vector<double>& lanes = result.offsets[bi];
+        lanes.assign(bus.stops.size() < 2 ? 0 : bus.stops.size() - 1, 0.0);
+
+        auto it = bus.stops.begin();
+        for (std::size_t k = 0; k + 1 < bus.stops.size(); ++k) {
+            const std::uint32_t from = it.Id();
+            const std::uint32_t to   = (++it).Id();
+            if (from == to) continue;
+
+            const std::uint64_t seg = SegmentKey(from, to);
+            const LaneKey key{seg, static_cast<std::uint32_t>(bi * 2 + (from > to))};
+            auto [lane_it, inserted] = lane_of.try_emplace(key, 0);
+            if (inserted) {
+                lane_it->second = lanes_on_segment[seg]++;
+            }
+            lanes[k] = lane_it->second;
         }
     }
 
+    std::uint32_t widest = 1;
+    for (const auto& [seg, count] : lanes_on_segment) {
+        widest = std::max(widest, count);
+    }
+    result.lane_width = std::clamp(kMaxBundleWidth / widest, kMinLaneWidth, kLaneWidth);
+
+    // проход 2: номер полосы -> сдвиг от оси пучка
+    for (std::size_t bi = 0; bi < buses.size(); ++bi) {
+        const Bus& bus = *buses[bi];
+        std::vector<double>& lanes = result.offsets[bi];
+        auto it = bus.stops.begin();
+        for (std::size_t k = 0; k < lanes.size(); ++k) {
+            const std::uint32_t from = it.Id();
+            const std::uint32_t to   = (++it).Id();
+            if (from == to) continue;
+
+            const double count = lanes_on_segment[SegmentKey(from, to)];
+            lanes[k] = (lanes[k] - (count - 1.0) / 2.0) * result.lane_width;
+        }
+    }
+    return result;
+}
+
+/**************************************************************************************************
+ * DrawBusOnStopMap — рисует маршрут на карте остановки (цвет + своя полоса на каждом сегменте)
+ **************************************************************************************************/
+static void DrawBusOnStopMap(SvgWriter& svg,
+                             const Bus& bus,
+                             const std::vector<Point>& pts,
+                             const std::string& color,
+                             const std::vector<double>& lane_offsets,
+                             double lane_width,
+                             bool markers) {
+    if (bus.stops.size() < 2) return;
+
     RouteDrawStyle st;
     st.stroke_color = color.c_str();
-    st.stroke_width = 4.0;
+    st.stroke_width = std::min(kStopMapStroke, std::max(1.0, lane_width - 2.0));
     st.emoji_sep = 10.0;
+    st.lane_offsets = &lane_offsets;
+    if (!markers) {
+        st.marker_spacing = std::numeric_limits<double>::infinity();
+    }
+
+    DrawBusSegments(svg, bus, pts, st);
+}
 
-    st.extra_shift = {perp.x * (BASE_OFFSET * offset_index),
-                      perp.y * (BASE_OFFSET * offset_index)};
+/**************************************************************************************************
+ * Расстановка подписей остановок (PlaceLabels)
+ *
+ * - сначала занимаются значки ВСЕХ остановок (кружок + 🚏): подпись не ляжет на чужой значок
+ * - затем каждая подпись пробует кандидатов kLabelCandidates по порядку; первый свободный
+ *   (и целиком лежащий на холсте) занимается, иначе подпись не выводится
+ * - занятость — разреженная сетка ячеек kLabelCellPx (хеш-множество): проверка подписи
+ *   стоит O(площадь / ячейка^2), весь проход — O(n) по числу остановок, на любом холсте
+ * - подпись выделенной остановки ставится первой и выводится всегда
+ * - размер подписи оценивается по числу символов (средняя ширина Verdana 14px)
+ **************************************************************************************************/
+struct Box {
+    double x0 = 0.0, y0 = 0.0, x1 = 0.0, y1 = 0.0;
+};
 
-    DrawBusSegments(svg, bus, proj, top_margin, st);
+// Положение подписи относительно точки остановки
+struct LabelSpot {
+    double dx = 30.0;
+    double dy = -10.0;         // базовая линия текста
+    bool anchor_end = false;   // text-anchor="end" (подпись слева от значка)
+    bool visible = true;
+};
+
+constexpr LabelSpot kLabelCandidates[] = {
+    { 30.0, -10.0, false, true},  // справа сверху (как раньше)
+    { 30.0,  22.0, false, true},  // справа снизу
+    {-12.0, -10.0, true,  true},  // слева сверху
+    {-12.0,  22.0, true,  true},  // слева снизу
+};
+
+constexpr double kLabelCharWidth = 8.5;
+constexpr double kLabelAscent    = 11.0;
+constexpr double kLabelDescent   = 3.0;
+constexpr double kLabelCellPx    = 8.0;
+
+static std::size_t Utf8Length(std::string_view s) {
+    std::size_t n = 0;
+    for (unsigned char c : s) {
+        n += (c & 0xC0) != 0x80;
+    }
+    return n;
+}
+
+// кружок (r до 9) + 🚏 (x+10, y+6, 16px) — см. DrawStops
+static Box StopIconBox(Point p) {
+    return {p.x - 9.0, p.y - 12.0, p.x + 26.0, p.y + 9.0};
+}
+
+static Box LabelBox(Point p, const LabelSpot& spot, std::string_view name) {
+    const double w = static_cast<double>(Utf8Length(name)) * kLabelCharWidth;
+    const double x = p.x + spot.dx;
+    const double y = p.y + spot.dy;
+    return spot.anchor_end ? Box{x - w, y - kLabelAscent, x, y + kLabelDescent}
+                           : Box{x, y - kLabelAscent, x + w, y + kLabelDescent};
+}
+
+static bool Contains(const Box& outer, const Box& b) {
+    return b.x0 >= outer.x0 && b.y0 >= outer.y0 && b.x1 <= outer.x1 && b.y1 <= outer.y1;
+}
+
+class OccupancyGrid {
+public:
+    explicit OccupancyGrid(std::size_t expected_boxes) {
+        cells_.reserve(expected_boxes * 16);
+    }
+
+    bool IsFree(const Box& b) const {
+        return ForEachCell(b, [this](std::uint64_t key) { return cells_.count(key) == 0; });
+    }
+
+    void Occupy(const Box& b) {
+        ForEachCell(b, [this](std::uint64_t key) { cells_.insert(key); return true; });
+    }
+
+private:
+    // fn(key) -> false прерывает обход; возвращает, дошёл ли обход до конца
+    template <typename Fn>
+    static bool ForEachCell(const Box& b, Fn&& fn) {
+        const auto cx0 = static_cast<std::int64_t>(std::floor(b.x0 / kLabelCellPx));
+        const auto cy0 = static_cast<std::int64_t>(std::floor(b.y0 / kLabelCellPx));
+        const auto cx1 = static_cast<std::int64_t>(std::floor(b.x1 / kLabelCellPx));
+        const auto cy1 = static_cast<std::int64_t>(std::floor(b.y1 / kLabelCellPx));
+        for (std::int64_t cx = cx0; cx <= cx1; ++cx) {
+            for (std::int64_t cy = cy0; cy <= cy1; ++cy) {
+                const std::uint64_t key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cx)) << 32)
+                                        | static_cast<std::uint32_t>(cy);
+                if (!fn(key)) return false;
+            }
+        }
+        return true;
+    }
+
+    std::unordered_set<std::uint64_t> cells_;
+};
+
+// Результат выровнен по stops: result[i] — подпись i-й остановки
+template <typename StopRange, typename PointOf>
+static std::vector<LabelSpot> PlaceLabels(const StopRange& stops,
+                                          const PointOf& point_of,
+                                          const Stop* highlight_stop,
+                                          const Box& canvas) {
+    const std::size_t n = std::size(stops);
+    std::vector<LabelSpot> spots(n);
+    OccupancyGrid grid(n);
+
+    for (const Stop* s : stops) {
+        grid.Occupy(StopIconBox(point_of(s)));
+    }
+
+    auto place = [&](std::size_t i, const Stop* s, bool force) {
+        const Point p = point_of(s);
+        for (const LabelSpot& cand : kLabelCandidates) {
+            const Box box = LabelBox(p, cand, s->name);
+            if (Contains(canvas, box) && grid.IsFree(box)) {
+                grid.Occupy(box);
+                spots[i] = cand;
+                return;
+            }
+        }
+        spots[i].visible = force;
+        if (force) {
+            grid.Occupy(LabelBox(p, spots[i], s->name));
+        }
+    };
+
+    std::size_t hi_index = n;
+    std::size_t i = 0;
+    for (const Stop* s : stops) {
+        if (s == highlight_stop) {
+            hi_index = i;
+            place(i, s, true);
+            break;
+        }
+        ++i;
+    }
+
+    i = 0;
+    for (const Stop* s : stops) {
+        if (i != hi_index) {
+            place(i, s, false);
+        }
+        ++i;
+    }
+    return spots;
 }
 
 /**************************************************************************************************
  * DrawStops — рисует остановки + подписи
+ *
+ * point_of(const Stop*) -> Point: где рисовать остановку (проекция уже готова у вызывающего)
+ * label_of(i, const Stop*) -> const LabelSpot&: куда ставить подпись (см. PlaceLabels)
  **************************************************************************************************/
-static void DrawStops(std::ostringstream& svg,
-                      const std::unordered_set<const Stop*>& stops,
-                      const SphereProjector& proj,
-                      double top_margin,
+template <typename StopRange, typename PointOf, typename LabelOf>
+static void DrawStops(SvgWriter& svg,
+                      const StopRange& stops,
+                      const PointOf& point_of,
+                      const LabelOf& label_of,
                       const Stop* highlight_stop = nullptr,
                       bool yellow_mode = false) {
+    std::size_t i = 0;
     for (const Stop* s : stops) {
-        Point p = proj(s->coord);
-        p.y += top_margin;
+        const Point p = point_of(s);
+        const LabelSpot& label = label_of(i++, s);
 
         const bool hi = (s == highlight_stop);
 
+        if (svg.IsCompact()) {
+            WriteUse(svg, hi ? "sh" : (yellow_mode ? "sy" : "sw"), p);
+            if (label.visible) {
+                svg << "  <text class=\"n\" x=\"" << (p.x + label.dx) << "\" y=\"" << (p.y + label.dy)
+                    << (label.anchor_end ? "\" text-anchor=\"end\">" : "\">")
+                    << s->name << "</text>\n";
+            }
+            continue;
+        }
+
         const double r = hi ? 9.0 : (yellow_mode ? 6.0 : 5.0);
         const std::string fill = hi ? "yellow" : (yellow_mode ? "yellow" : "white");
         const std::string stroke = hi ? "red" : "black";
@@ -299,16 +801,66 @@ static void DrawStops(std::ostringstream& svg,
             << "\" font-size=\"16\" font-family=\"" << EmojiFont() << "\">"
             << u8"🚏" << "</text>\n";
 
-        svg << "  <text x=\"" << (p.x + 30) << "\" y=\"" << (p.y - 10)
-            << "\" font-size=\"14\" font-family=\"Verdana\" fill=\"black\">"
+        if (!label.visible) continue;
+
+        svg << "  <text x=\"" << (p.x + label.dx) << "\" y=\"" << (p.y + label.dy)
+            << "\" font-size=\"14\" font-family=\"Verdana\" fill=\"black\""
+            << (label.anchor_end ? " text-anchor=\"end\">" : ">")
             << s->name << "</text>\n";
     }
 }
 
+// Подписи расставлены заранее, по порядку stops (общий случай для одного холста)
+template <typename StopRange, typename PointOf>
+static void DrawStopsWithLabels(SvgWriter& svg,
+                                const StopRange& stops,
+                                const PointOf& point_of,
+                                double width, double height,
+                                const Stop* highlight_stop = nullptr,
+                                bool yellow_mode = false) {
+    const std::vector<LabelSpot> labels =
+        PlaceLabels(stops, point_of, highlight_stop, Box{0.0, 0.0, width, height});
+    DrawStops(svg, stops, point_of,
+              [&labels](std::size_t i, const Stop*) -> const LabelSpot& { return labels[i]; },
+              highlight_stop, yellow_mode);
+}
+
+/**************************************************************************************************
+ * LegendLayout — легенда маршрутов в шапке Stop SVG
+ *
+ * - до kMaxLegendRows маршрутов — один столбец (как раньше)
+ * - больше — несколько столбцов по kLegendColumnWidth, сколько влезает по ширине
+ * - не влезли все — последняя ячейка "+N more"
+ **************************************************************************************************/
+constexpr std::size_t kMaxLegendRows = 6;
+constexpr double kLegendColumnWidth = 160.0;
+
+struct LegendLayout {
+    std::size_t columns = 1;
+    std::size_t rows = 0;
+    std::size_t shown = 0;  // маршрутов в легенде (остальные — "+N more")
+};
+
+static LegendLayout MakeLegendLayout(std::size_t bus_count, double width, double padding) {
+    LegendLayout layout;
+    if (bus_count <= kMaxLegendRows) {
+        layout.rows = bus_count;
+        layout.shown = bus_count;
+        return layout;
+    }
+
+    const auto fit = static_cast<std::size_t>(std::max(1.0, (width - 2 * padding) / kLegendColumnWidth));
+    layout.columns = std::min(fit, (bus_count + kMaxLegendRows - 1) / kMaxLegendRows);
+    layout.rows = std::min(kMaxLegendRows, (bus_count + layout.columns - 1) / layout.columns);
+    const std::size_t cells = layout.rows * layout.columns;
+    layout.shown = bus_count <= cells ? bus_count : cells - 1;
+    return layout;
+}
+
 /**************************************************************************************************
  * DrawHeader — шапка Stop SVG (подложка + заголовок + легенда)
  **************************************************************************************************/
-static void DrawHeader(std::ostringstream& svg,
+static void DrawHeader(SvgWriter& svg,
                        const Stop& stop,
                        const std::vector<const Bus*>& buses,
                        double width,
@@ -337,133 +889,724 @@ static void DrawHeader(std::ostringstream& svg,
 
     y += 20.0;
 
+    const LegendLayout layout = MakeLegendLayout(buses.size(), width, padding);
+
+    // заполнение по столбцам: порядок чтения тот же, что и раньше для одного столбца
     const auto& pal = ColorPalette();
-    for (size_t i = 0; i < buses.size(); ++i) {
+    for (size_t i = 0; i < layout.shown; ++i) {
         const std::string& color = pal[i % pal.size()];
+        const double cx = x + static_cast<double>(i / layout.rows) * kLegendColumnWidth;
+        const double cy = y + static_cast<double>(i % layout.rows) * 18.0;
 
-        svg << "  <rect x=\"" << x << "\" y=\"" << (y - 12)
+        svg << "  <rect x=\"" << cx << "\" y=\"" << (cy - 12)
             << "\" width=\"14\" height=\"14\" fill=\"" << color
             << "\" stroke=\"black\" stroke-width=\"1\" />\n";
 
-        svg << "  <text x=\"" << (x + 20) << "\" y=\"" << y
+        svg << "  <text x=\"" << (cx + 20) << "\" y=\"" << cy
             << "\" font-size=\"14\" font-family=\"Verdana\" fill=\"black\">"
             << "Bus " << buses[i]->name << "</text>\n";
+    }
+
+    if (layout.shown < buses.size()) {
+        const std::size_t i = layout.shown;
+        svg << "  <text x=\"" << (x + static_cast<double>(i / layout.rows) * kLegendColumnWidth + 20)
+            << "\" y=\"" << (y + static_cast<double>(i % layout.rows) * 18.0)
+            << "\" font-size=\"14\" font-family=\"Verdana\" fill=\"black\">"
+            << "+" << (buses.size() - layout.shown) << " more</text>\n";
+    }
+}
 
-        y += 18.0;
+// LOD: сегмент короче kLodTolerancePx (обе остановки в одном пикселе) не рисуется
+static bool IsVisibleSegment(Point a, Point b) {
+    return std::hypot(b.x - a.x, b.y - a.y) >= kLodTolerancePx;
+}
+
+static void DrawSegmentLine(SvgWriter& svg, Point a, Point b,
+                            const std::string& color, double stroke_width) {
+    if (!IsVisibleSegment(a, b)) {
+        return;
     }
+    svg << "  <line x1=\"" << a.x << "\" y1=\"" << a.y
+        << "\" x2=\"" << b.x << "\" y2=\"" << b.y
+        << "\" stroke=\"" << color
+        << "\" stroke-width=\"" << stroke_width
+        << "\" stroke-linecap=\"round\" />\n";
 }
 
-} // namespace detail
+/**************************************************************************************************
+ * CollectNetworkSegments — уникальные сегменты сети
+ *
+ * - A->B и B->A — один и тот же сегмент (ключ = пара id в каноническом порядке)
+ * - цвет сегмента — цвет первого маршрута, который его прошёл
+ * - размер результата ограничен размером сети, а не суммой длин маршрутов
+ **************************************************************************************************/
+struct NetworkSegment {
+    std::uint32_t from = 0;
+    std::uint32_t to = 0;
+    std::uint32_t color = 0;  // индекс в ColorPalette()
+};
 
-// ============================== PUBLIC API ==============================
+// Сегменты сети (индексы в segments); point_of(stop_id) -> Point.
+// Компактно — один <path> на цвет палитры, иначе <line> на сегмент в исходном порядке.
+template <typename IndexRange, typename PointOf>
+static void DrawNetworkSegments(SvgWriter& svg,
+                                const std::vector<NetworkSegment>& segments,
+                                const IndexRange& indices,
+                                const PointOf& point_of,
+                                double stroke_width) {
+    const auto& pal = ColorPalette();
 
-std::string RenderBusSvg(const transport_catalogue::domain::Bus& bus,
-                         double width, double height, double padding) {
-    using namespace detail;
+    if (!svg.IsCompact()) {
+        for (std::uint32_t i : indices) {
+            const NetworkSegment& seg = segments[i];
+            DrawSegmentLine(svg, point_of(seg.from), point_of(seg.to), pal[seg.color], stroke_width);
+        }
+        return;
+    }
 
-    std::ostringstream svg;
-    svg << std::fixed << std::setprecision(6);
+    for (std::uint32_t color = 0; color < pal.size(); ++color) {
+        RelativePath path(svg, pal[color], stroke_width);
+        for (std::uint32_t i : indices) {
+            const NetworkSegment& seg = segments[i];
+            if (seg.color != color) continue;
+            const Point a = point_of(seg.from);
+            const Point b = point_of(seg.to);
+            if (IsVisibleSegment(a, b)) {
+                path.Segment(a, b);
+            }
+        }
+        path.Finish();
+    }
+}
 
-    const double top_margin = 70.0;
+static std::vector<NetworkSegment> CollectNetworkSegments(const std::vector<const Bus*>& buses,
+                                                          std::size_t stop_count) {
+    std::vector<NetworkSegment> result;
+    std::unordered_set<std::uint64_t> seen;
+    seen.reserve(stop_count * 2);
+
+    const std::size_t palette_size = ColorPalette().size();
+    for (size_t i = 0; i < buses.size(); ++i) {
+        const Bus& bus = *buses[i];
+        auto it = bus.stops.begin();
+        for (size_t k = 1; k < bus.stops.size(); ++k) {
+            const std::uint32_t from = it.Id();
+            const std::uint32_t to   = (++it).Id();
+            if (from == to) continue;
+
+            const std::uint64_t key = (static_cast<std::uint64_t>(std::min(from, to)) << 32)
+                                    | std::max(from, to);
+            if (seen.insert(key).second) {
+                result.push_back({from, to, static_cast<std::uint32_t>(i % palette_size)});
+            }
+        }
+    }
+    return result;
+}
 
-    std::vector<Coordinates> coords;
-    coords.reserve(bus.stops.size());
-    for (const Stop* s : bus.stops) {
-        coords.push_back(s->coord);
+/**************************************************************************************************
+ * Тайловая пирамида (z/x/y.svg)
+ *
+ * - TileProjector: проекция сети на "мир" размером tile_size * 2^z, сдвинутая к тайлу (x, y)
+ * - TileBin:       что попало в тайл (индексы уникальных сегментов + остановки)
+ * - BinLevel:      пространственное разбиение одного уровня z: сегменты — по тайлам, которые
+ *                  линия (с толщиной) действительно пересекает, остановки — по bbox значка/подписи
+ **************************************************************************************************/
+class TileProjector {
+public:
+    TileProjector(double scale, double dx, double dy)
+        : scale_(scale), dx_(dx), dy_(dy) {}
+
+    // точка уровня z=0 -> пиксели тайла
+    Point Apply(Point p) const {
+        return {p.x * scale_ - dx_, p.y * scale_ - dy_};
     }
 
-    SphereProjector proj(coords, width, height - top_margin, padding);
+private:
+    double scale_, dx_, dy_;
+};
+
+struct TileBin {
+    std::vector<std::uint32_t> segments;
+    std::vector<const Stop*> stops;
+};
+
+constexpr int kMaxTileZoom = 12;
+constexpr double kTilePaddingShare = 0.05;
+constexpr double kTileStrokeWidth = 2.0;
 
+// ключ тайла: x в старших 32 битах, y — в младших
+static std::uint64_t TileKey(std::uint32_t x, std::uint32_t y) {
+    return (static_cast<std::uint64_t>(x) << 32) | y;
+}
+
+static std::unordered_map<std::uint64_t, TileBin>
+BinLevel(const std::vector<NetworkSegment>& segments,
+         const std::vector<const Stop*>& stops,
+         const std::vector<Point>& base_points,
+         const std::vector<LabelSpot>& labels_by_id,
+         double scale, double tile_size, std::uint32_t tiles_per_side, double stroke_width) {
+    std::unordered_map<std::uint64_t, TileBin> bins;
+
+    auto tile_range = [&](double lo, double hi, std::uint32_t& first, std::uint32_t& last) {
+        const double max_index = static_cast<double>(tiles_per_side - 1);
+        first = static_cast<std::uint32_t>(std::clamp(std::floor(lo / tile_size), 0.0, max_index));
+        last  = static_cast<std::uint32_t>(std::clamp(std::floor(hi / tile_size), 0.0, max_index));
+    };
+
+    auto for_each_tile = [&](double x0, double y0, double x1, double y1, auto&& fn) {
+        std::uint32_t tx0, tx1, ty0, ty1;
+        tile_range(x0, x1, tx0, tx1);
+        tile_range(y0, y1, ty0, ty1);
+        for (std::uint32_t tx = tx0; tx <= tx1; ++tx) {
+            for (std::uint32_t ty = ty0; ty <= ty1; ++ty) {
+                fn(bins[TileKey(tx, ty)]);
+            }
+        }
+    };
+
+    // Сегмент — только в тайлы, которые задевает сама линия (а не весь её bbox):
+    // по столбцам тайлов, в каждом — отрезок линии внутри столбца (с запасом half_w по x),
+    // его диапазон y с запасом half_w -> строки. Число тайлов ~ длина / тайл, а не площадь bbox.
+    // half_w — половина толщины штриха: скруглённые концы и края линии выходят за осевую
+    // ровно на неё, так что квадратный запас ±half_w накрывает весь штрих.
+    const double half_w = stroke_width / 2;
+    for (std::uint32_t i = 0; i < segments.size(); ++i) {
+        Point a = base_points[segments[i].from];
+        Point b = base_points[segments[i].to];
+        a = {a.x * scale, a.y * scale};
+        b = {b.x * scale, b.y * scale};
+        if (b.x < a.x) {
+            std::swap(a, b);
+        }
+        const double dx = b.x - a.x;
+        auto y_at = [&](double x) { return dx > 0.0 ? a.y + (b.y - a.y) * (x - a.x) / dx : a.y; };
+
+        std::uint32_t tx0, tx1;
+        tile_range(a.x - half_w, b.x + half_w, tx0, tx1);
+        for (std::uint32_t tx = tx0; tx <= tx1; ++tx) {
+            const double xl = std::clamp(tx * tile_size - half_w, a.x, b.x);
+            const double xr = std::clamp((tx + 1) * tile_size + half_w, a.x, b.x);
+            double yl = y_at(xl);
+            double yr = y_at(xr);
+            if (dx == 0.0) {
+                yl = a.y;
+                yr = b.y;
+            }
+            std::uint32_t ty0, ty1;
+            tile_range(std::min(yl, yr) - half_w, std::max(yl, yr) + half_w, ty0, ty1);
+            for (std::uint32_t ty = ty0; ty <= ty1; ++ty) {
+                bins[TileKey(tx, ty)].segments.push_back(i);
+            }
+        }
+    }
+
+    // остановка попадает во все тайлы, которые задевают её значок или подпись
+    for (const Stop* s : stops) {
+        const Point p{base_points[s->id].x * scale, base_points[s->id].y * scale};
+        Box box = StopIconBox(p);
+        const LabelSpot& label = labels_by_id[s->id];
+        if (label.visible) {
+            const Box lb = LabelBox(p, label, s->name);
+            box = {std::min(box.x0, lb.x0), std::min(box.y0, lb.y0),
+                   std::max(box.x1, lb.x1), std::max(box.y1, lb.y1)};
+        }
+        for_each_tile(box.x0, box.y0, box.x1, box.y1,
+                      [s](TileBin& bin) { bin.stops.push_back(s); });
+    }
+
+    return bins;
+}
+
+static void WriteSvgOpen(SvgWriter& svg, double width, double height, bool background = true) {
     svg << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
     svg << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" "
         << "width=\"" << width << "\" height=\"" << height << "\">\n";
 
-    svg << "  <rect x=\"0\" y=\"0\" width=\"" << width << "\" height=\"" << height
-        << "\" fill=\"white\" />\n";
+    if (svg.IsCompact()) {
+        WriteSvgDefs(svg);
+    }
+
+    if (background) {
+        svg << "  <rect x=\"0\" y=\"0\" width=\"" << width << "\" height=\"" << height
+            << "\" fill=\"white\" />\n";
+    }
+}
+
+static bool WriteTile(SvgWriter& svg,
+                      const std::string& path,
+                      const TileBin& bin,
+                      const std::vector<NetworkSegment>& segments,
+                      const std::vector<Point>& base_points,
+                      const std::vector<LabelSpot>& labels_by_id,
+                      const TileProjector& proj,
+                      double tile_size, double stroke_width) {
+    if (!svg.Open(path)) {
+        return false;
+    }
+
+    // тайлы накладываются на подложку просмотрщика: без белого фона
+    WriteSvgOpen(svg, tile_size, tile_size, false);
+
+    DrawNetworkSegments(svg, segments, bin.segments,
+                        [&](std::uint32_t id) { return proj.Apply(base_points[id]); },
+                        stroke_width);
+
+    // подписи расставлены на весь уровень сразу: на стыке тайлов они совпадают
+    DrawStops(svg, bin.stops,
+              [&](const Stop* s) { return proj.Apply(base_points[s->id]); },
+              [&](std::size_t, const Stop* s) -> const LabelSpot& { return labels_by_id[s->id]; },
+              nullptr, false);
+
+    svg << "</svg>\n";
+    return svg.Close();
+}
+
+/**************************************************************************************************
+ * UniqueStops — остановки без повторов в порядке ПЕРВОГО появления
+ *
+ * Порядок элементов SVG зависит только от входных данных (а не от адресов в памяти),
+ * поэтому одинаковые запросы дают одинаковые байты — их можно кешировать и сравнивать.
+ * AddRoute возвращает номера посещений маршрута в Ordered(): по ним берутся уже
+ * спроецированные точки (см. LocalProjection) без повторного поиска.
+ **************************************************************************************************/
+class UniqueStops {
+public:
+    explicit UniqueStops(std::size_t expected) {
+        index_.reserve(expected);
+        ordered_.reserve(expected);
+    }
+
+    std::uint32_t Add(const Stop* s) {
+        const auto [it, inserted] = index_.try_emplace(s, static_cast<std::uint32_t>(ordered_.size()));
+        if (inserted) {
+            ordered_.push_back(s);
+        }
+        return it->second;
+    }
+
+    std::vector<std::uint32_t> AddRoute(const Bus& bus) {
+        std::vector<std::uint32_t> visits;
+        visits.reserve(bus.stops.size());
+        for (const Stop* s : bus.stops) {
+            visits.push_back(Add(s));
+        }
+        return visits;
+    }
+
+    std::uint32_t IndexOf(const Stop* s) const { return index_.at(s); }
+    const std::vector<const Stop*>& Ordered() const { return ordered_; }
+
+private:
+    std::unordered_map<const Stop*, std::uint32_t> index_;
+    std::vector<const Stop*> ordered_;
+};
+
+/**************************************************************************************************
+ * LocalProjection — карта маршрута/остановки в СВОЁМ viewport (по bbox своих остановок)
+ *
+ * - bbox — один проход по уникальным остановкам (тот же, что по всем посещениям: множество то же)
+ * - каждая уникальная остановка проецируется один раз; линии маршрутов (по номерам посещений)
+ *   и значки/подписи берут одни и те же точки
+ **************************************************************************************************/
+class LocalProjection {
+public:
+    LocalProjection(const UniqueStops& stops, double width, double height, double padding,
+                    double top_margin)
+        : stops_(stops) {
+        transport_catalogue::geo::BoundingBox box;
+        for (const Stop* s : stops.Ordered()) {
+            box.Extend(s->coord);
+        }
+
+        const SphereProjector proj(box, width, height - top_margin, padding);
+        points_.reserve(stops.Ordered().size());
+        for (const Stop* s : stops.Ordered()) {
+            Point p = proj(s->coord);
+            p.y += top_margin;
+            points_.push_back(p);
+        }
+    }
+
+    Point operator()(const Stop* s) const { return points_[stops_.IndexOf(s)]; }
+
+    // точки маршрута: одна на каждое посещение (visits — из UniqueStops::AddRoute)
+    std::vector<Point> Route(const std::vector<std::uint32_t>& visits) const {
+        std::vector<Point> pts;
+        pts.reserve(visits.size());
+        for (const std::uint32_t i : visits) {
+            pts.push_back(points_[i]);
+        }
+        return pts;
+    }
+
+private:
+    const UniqueStops& stops_;
+    std::vector<Point> points_;  // по номеру в UniqueStops::Ordered()
+};
+
+constexpr double kHeaderTopY       = 30.0;
+constexpr double kTitleLineHeight  = 22.0;
+constexpr double kSecondLineHeight = 20.0;
+constexpr double kLegendLineStep   = 18.0;
+constexpr double kGapHeaderToMap   = 25.0;
+
+static double StopHeaderHeight(std::size_t bus_count, double width, double padding) {
+    const LegendLayout layout = MakeLegendLayout(bus_count, width, padding);
+    return kHeaderTopY + kTitleLineHeight + kSecondLineHeight + layout.rows * kLegendLineStep;
+}
+
+} // namespace detail
+
+// ============================== RenderContext ==============================
+
+RenderContext::RenderContext(const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+                             double width, double height, double padding, double top_margin)
+    : width_(width)
+    , height_(height)
+    , padding_(padding)
+    , top_margin_(top_margin) {
+    using namespace detail;
+
+    const auto& stops = catalogue.GetAllStops();
+
+    // один min/max-проход и одна проекция на остановку — на весь срок жизни контекста
+    // (points_ — по Stop::id)
+    transport_catalogue::geo::BoundingBox box;
+    for (const Stop* s : stops) {
+        box.Extend(s->coord);
+    }
+    const SphereProjector proj(box, width, height - top_margin, padding);
+
+    points_.resize(stops.size());
+    for (const Stop* s : stops) {
+        Point p = proj(s->coord);
+        p.y += top_margin;
+        points_[s->id] = p;
+    }
+}
+
+// ============================== PUBLIC API ==============================
+
+void RenderBusSvg(SvgWriter& svg,
+                  const transport_catalogue::domain::Bus& bus,
+                  double width, double height, double padding) {
+    using namespace detail;
+
+    const double top_margin = 70.0;
+
+    UniqueStops uniq(bus.stops.size());
+    const std::vector<std::uint32_t> visits = uniq.AddRoute(bus);
+    const LocalProjection proj(uniq, width, height, padding, top_margin);
+
+    WriteSvgOpen(svg, width, height);
 
     RouteDrawStyle st;
     st.stroke_color = "black";
     st.stroke_width = 3.0;
     st.emoji_sep    = 12.0;
 
-    DrawBusSegments(svg, bus, proj, top_margin, st);
-
-    std::unordered_set<const Stop*> uniq;
-    uniq.reserve(bus.stops.size());
-    for (const Stop* s : bus.stops) {
-        uniq.insert(s);
-    }
-
-    DrawStops(svg, uniq, proj, top_margin, nullptr, true);
+    DrawBusSegments(svg, bus, proj.Route(visits), st);
+    DrawStopsWithLabels(svg, uniq.Ordered(), proj, width, height, nullptr, true);
 
     svg << "  <text x=\"" << padding << "\" y=\"" << 30
         << "\" font-size=\"22\" font-family=\"Verdana\" fill=\"black\">"
         << "Bus: " << bus.name << "</text>\n";
 
     svg << "</svg>\n";
-    return svg.str();
 }
 
-std::string RenderStopSvg(const transport_catalogue::domain::Stop& stop,
-                          const std::vector<const transport_catalogue::domain::Bus*>& buses,
-                          double width, double height, double padding) {
+void RenderStopSvg(SvgWriter& svg,
+                   const transport_catalogue::domain::Stop& stop,
+                   const std::vector<const transport_catalogue::domain::Bus*>& buses,
+                   double width, double height, double padding) {
     using namespace detail;
 
-    std::ostringstream svg;
-    svg << std::fixed << std::setprecision(6);
+    const double header_height = StopHeaderHeight(buses.size(), width, padding);
+    const double top_margin = header_height + kGapHeaderToMap;
 
-    constexpr double kHeaderTopY       = 30.0;
-    constexpr double kTitleLineHeight  = 22.0;
-    constexpr double kSecondLineHeight = 20.0;
-    constexpr double kLegendLineStep   = 18.0;
-    constexpr double kGapHeaderToMap   = 25.0;
+    UniqueStops uniq(512);
+    uniq.Add(&stop);
+    std::vector<std::vector<std::uint32_t>> visits;
+    visits.reserve(buses.size());
+    for (const Bus* b : buses) {
+        visits.push_back(uniq.AddRoute(*b));
+    }
+    const LocalProjection proj(uniq, width, height, padding, top_margin);
 
-    const double header_height =
-        kHeaderTopY + kTitleLineHeight + kSecondLineHeight + buses.size() * kLegendLineStep;
+    WriteSvgOpen(svg, width, height);
 
-    const double top_margin = header_height + kGapHeaderToMap;
+    const StopMapLanes lanes = AssignLanes(buses);
+    const bool markers = buses.size() <= kStopMapMarkerRoutes;
+
+    const auto& pal = ColorPalette();
+    for (size_t i = 0; i < buses.size(); ++i) {
+        const std::string& color = pal[i % pal.size()];
+        DrawBusOnStopMap(svg, *buses[i], proj.Route(visits[i]), color,
+                         lanes.offsets[i], lanes.lane_width, markers);
+    }
 
-    std::vector<Coordinates> coords;
-    coords.reserve(256);
-    coords.push_back(stop.coord);
+    DrawStopsWithLabels(svg, uniq.Ordered(), proj, width, height, &stop, false);
+    DrawHeader(svg, stop, buses, width, padding, header_height);
 
-    for (const Bus* b : buses) {
-        for (const Stop* s : b->stops) {
-            coords.push_back(s->coord);
+    svg << "</svg>\n";
+}
+
+void RenderNetworkSvg(SvgWriter& svg,
+                      const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+                      double width, double height, double padding) {
+    RenderNetworkSvg(svg, RenderContext(catalogue, width, height, padding), catalogue);
+}
+
+void RenderNetworkSvg(SvgWriter& svg, const RenderContext& ctx,
+                      const transport_catalogue::catalogue::TransportCatalogue& catalogue) {
+    using namespace detail;
+
+    const auto& stops = catalogue.GetAllStops();
+    const auto& buses = catalogue.GetAllBuses();
+    const auto& points = ctx.Points();
+
+    WriteSvgOpen(svg, ctx.Width(), ctx.Height());
+
+    const std::vector<NetworkSegment> segments = CollectNetworkSegments(buses, stops.size());
+    std::vector<std::uint32_t> all(segments.size());
+    for (std::uint32_t i = 0; i < all.size(); ++i) all[i] = i;
+
+    DrawNetworkSegments(svg, segments, all,
+                        [&points](std::uint32_t id) { return points[id]; }, 2.0);
+
+    // каждая остановка (и её подпись) — один раз, сколько бы маршрутов через неё ни шло
+    DrawStopsWithLabels(svg, stops, [&ctx](const Stop* s) { return ctx.PointOf(*s); },
+                        ctx.Width(), ctx.Height(), nullptr, false);
+
+    svg << "  <text x=\"" << ctx.Padding() << "\" y=\"" << 30
+        << "\" font-size=\"22\" font-family=\"Verdana\" fill=\"black\">"
+        << "Network: " << buses.size() << " routes, " << stops.size() << " stops</text>\n";
+
+    svg << "</svg>\n";
+}
+
+TileExportResult ExportTilePyramid(const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+                                   const TileExportOptions& options) {
+    using namespace detail;
+    namespace fs = std::filesystem;
+
+    TileExportResult result;
+
+    const auto& stops = catalogue.GetAllStops();
+    const auto& buses = catalogue.GetAllBuses();
+    const double tile_size = options.tile_size;
+    const int max_zoom = std::clamp(options.max_zoom, 0, kMaxTileZoom);
+
+    // уровень z=0: вся сеть в одном тайле; остальные уровни — масштаб 2^z от него
+    const RenderContext base(catalogue, tile_size, tile_size, tile_size * kTilePaddingShare, 0.0);
+    const std::vector<Point>& base_points = base.Points();
+
+    const std::vector<NetworkSegment> segments = CollectNetworkSegments(buses, stops.size());
+
+    util::ThreadPool pool(options.threads);
+    std::atomic<std::size_t> written{0};
+    std::atomic<std::size_t> failed{0};
+
+    for (int z = 0; z <= max_zoom; ++z) {
+        const std::uint32_t tiles_per_side = std::uint32_t{1} << z;
+        const double scale = static_cast<double>(tiles_per_side);
+
+        // подписи — на весь "мир" уровня z (tile_size * 2^z), с индексом по Stop::id
+        const double world = tile_size * scale;
+        const std::vector<LabelSpot> placed = PlaceLabels(
+            stops, [&](const Stop* s) { return Point{base_points[s->id].x * scale,
+                                                     base_points[s->id].y * scale}; },
+            nullptr, Box{0.0, 0.0, world, world});
+        std::vector<LabelSpot> labels_by_id(base_points.size());
+        for (std::size_t i = 0; i < stops.size(); ++i) {
+            labels_by_id[stops[i]->id] = placed[i];
+        }
+
+        const auto bins = BinLevel(segments, stops, base_points, labels_by_id,
+                                   scale, tile_size, tiles_per_side, kTileStrokeWidth);
+
+        result.tiles_empty += static_cast<std::size_t>(tiles_per_side) * tiles_per_side - bins.size();
+
+        // каталоги z/x создаём заранее, в одном потоке
+        const fs::path zoom_dir = fs::path(options.out_dir) / std::to_string(z);
+        std::vector<bool> column_ready(tiles_per_side, false);
+        for (const auto& [key, bin] : bins) {
+            const auto x = static_cast<std::uint32_t>(key >> 32);
+            if (!column_ready[x]) {
+                std::error_code ec;
+                fs::create_directories(zoom_dir / std::to_string(x), ec);
+                column_ready[x] = true;
+            }
         }
+
+        for (const auto& [key, bin] : bins) {
+            const auto x = static_cast<std::uint32_t>(key >> 32);
+            const auto y = static_cast<std::uint32_t>(key & 0xFFFFFFFFu);
+
+            pool.Submit([&, x, y, bin_ptr = &bin] {
+                // один буфер на поток — переиспользуется всеми тайлами этого потока
+                thread_local SvgWriter svg;
+                svg.SetPrecision(options.precision);
+                svg.SetCompact(options.compact);
+
+                const TileProjector proj(scale, x * tile_size, y * tile_size);
+                const std::string path =
+                    (zoom_dir / std::to_string(x) / (std::to_string(y) + ".svg")).string();
+
+                if (WriteTile(svg, path, *bin_ptr, segments, base_points, labels_by_id, proj,
+                              tile_size, kTileStrokeWidth)) {
+                    ++written;
+                } else {
+                    ++failed;
+                }
+            });
+        }
+
+        // bins живут до конца уровня
+        pool.Wait();
     }
 
-    SphereProjector proj(coords, width, height - top_margin, padding);
+    result.tiles_written = written;
+    result.tiles_failed = failed;
+    return result;
+}
 
-    svg << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-    svg << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" "
-        << "width=\"" << width << "\" height=\"" << height << "\">\n";
+std::string MakeSafeFilename(std::string_view name) {
+    std::string s(name);
+    for (char& ch : s) {
+        if (ch == ' ') ch = '_';
+    }
+    return s;
+}
 
-    svg << "  <rect x=\"0\" y=\"0\" width=\"" << width << "\" height=\"" << height
-        << "\" fill=\"white\" />\n";
+namespace detail {
 
-    const auto& pal = ColorPalette();
-    for (size_t i = 0; i < buses.size(); ++i) {
-        const Bus* bus = buses[i];
-        const std::string& color = pal[i % pal.size()];
-        DrawBusOnStopMap(svg, *bus, proj, color, top_margin, static_cast<double>(i));
+// Уникальные имена файлов пакетного экспорта. Ключ сравнения — в нижнем регистре:
+// на Windows/macOS "Bus_A.svg" и "bus_a.svg" — один и тот же файл.
+class UniqueFilenames {
+public:
+    // stem (без .svg) -> свободное имя файла; renamed = true, если пришлось добавить суффикс
+    std::string Claim(const std::string& stem, bool& renamed) {
+        std::string name = stem + ".svg";
+        renamed = false;
+        for (std::size_t n = 2; !used_.insert(Fold(name)).second; ++n) {
+            name = stem + "_" + std::to_string(n) + ".svg";
+            renamed = true;
+        }
+        return name;
     }
 
-    std::unordered_set<const Stop*> uniq;
-    uniq.reserve(512);
-    uniq.insert(&stop);
+private:
+    static std::string Fold(std::string s) {
+        for (char& ch : s) {
+            if (ch >= 'A' && ch <= 'Z') ch = static_cast<char>(ch - 'A' + 'a');
+        }
+        return s;
+    }
 
-    for (const Bus* b : buses) {
-        for (const Stop* s : b->stops) {
-            uniq.insert(s);
+    std::unordered_set<std::string> used_;
+};
+
+} // namespace detail
+
+BatchExportResult ExportAllSvgs(const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+                                const BatchExportOptions& options) {
+    using namespace detail;
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    fs::create_directories(options.out_dir, ec);
+    const fs::path out_dir(options.out_dir);
+
+    std::atomic<std::size_t> bus_files{0};
+    std::atomic<std::size_t> stop_files{0};
+    std::atomic<std::size_t> failed{0};
+
+    // один буфер на поток: переиспользуется всеми файлами, которые рендерит этот поток
+    auto write_file = [&options, &failed](const fs::path& path, std::atomic<std::size_t>& counter,
+                                          auto&& render) {
+        thread_local SvgWriter svg;
+        svg.SetPrecision(options.precision);
+        svg.SetCompact(options.compact);
+        if (!svg.Open(path.string())) {
+            ++failed;
+            return;
         }
+        render(svg);
+        if (svg.Close()) {
+            ++counter;
+        } else {
+            ++failed;
+        }
+    };
+
+    BatchExportResult result;
+    UniqueFilenames filenames;
+    auto claim_path = [&](std::string_view prefix, std::string_view name) {
+        bool renamed = false;
+        std::string file = filenames.Claim(std::string(prefix) + MakeSafeFilename(name), renamed);
+        if (renamed) {
+            result.collisions.push_back(std::string(name) + " -> " + file);
+        }
+        return out_dir / file;
+    };
+
+    util::ThreadPool pool(options.threads);
+
+    for (const Bus* bus : catalogue.GetAllBuses()) {
+        pool.Submit([&, bus, path = claim_path("bus_", bus->name)] {
+            write_file(path, bus_files,
+                       [&](SvgWriter& svg) {
+                           RenderBusSvg(svg, *bus, options.width, options.height, options.padding);
+                       });
+        });
     }
 
-    DrawStops(svg, uniq, proj, top_margin, &stop, false);
-    DrawHeader(svg, stop, buses, width, padding, header_height);
+    if (options.include_stops) {
+        for (const Stop* stop : catalogue.GetAllStops()) {
+            if (catalogue.GetBusSpanByStop(stop).empty()) {
+                continue;
+            }
+            pool.Submit([&, stop, path = claim_path("stop_", stop->name)] {
+                const auto buses_set = catalogue.GetBusSpanByStop(stop);
+                std::vector<const Bus*> buses(buses_set.begin(), buses_set.end());
+                std::sort(buses.begin(), buses.end(),
+                          [](const Bus* a, const Bus* b) { return a->name < b->name; });
+                if (options.max_routes_per_stop != 0 && buses.size() > options.max_routes_per_stop) {
+                    buses.resize(options.max_routes_per_stop);
+                }
+
+                write_file(path, stop_files,
+                           [&](SvgWriter& svg) {
+                               RenderStopSvg(svg, *stop, buses,
+                                             options.width, options.height, options.padding);
+                           });
+            });
+        }
+    }
 
-    svg << "</svg>\n";
-    return svg.str();
+    pool.Wait();
+
+    result.bus_files = bus_files;
+    result.stop_files = stop_files;
+    result.failed = failed;
+    return result;
+}
+
+std::string RenderBusSvg(const transport_catalogue::domain::Bus& bus,
+                         double width, double height, double padding) {
+    SvgWriter svg;
+    RenderBusSvg(svg, bus, width, height, padding);
+    return svg.TakeString();
+}
+
+std::string RenderStopSvg(const transport_catalogue::domain::Stop& stop,
+                          const std::vector<const transport_catalogue::domain::Bus*>& buses,
+                          double width, double height, double padding) {
+    SvgWriter svg;
+    RenderStopSvg(svg, stop, buses, width, height, padding);
+    return svg.TakeString();
 }
 
 } // namespace transport_catalogue::render
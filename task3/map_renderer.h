@@ -5,15 +5,153 @@
  * ADDED:
  *   - namespace transport_catalogue::render
  *   - Глобальные using RenderBusSvg/RenderStopSvg для совместимости
+ *   - Перегрузки RenderBusSvg/RenderStopSvg, пишущие в SvgWriter
+ *   - RenderNetworkSvg — карта всей сети
+ *   - RenderContext — проекция остановок сети один раз на viewport (карта сети, тайлы)
+ *   - ExportTilePyramid — параллельный экспорт сети в тайлы z/x/y.svg
+ *   - ExportAllSvgs — пакетный экспорт всех маршрутов/остановок (+ MakeSafeFilename)
  **************************************************************************************************/
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "svg_writer.h"
 #include "transport_catalogue.h"
 
 namespace transport_catalogue::render {
 
+// Точка на SVG-холсте (пиксели)
+struct Point {
+    double x = 0.0;
+    double y = 0.0;
+};
+
+/**************************************************************************************************
+ * RenderContext — все остановки каталога, спроецированные ОДИН раз под заданный viewport
+ *
+ * - один проход min/max и одна проекция на остановку при создании
+ * - карта сети и тайлы берут готовые точки по Stop::id (карты маршрута/остановки строят
+ *   свой viewport по своим остановкам — и тоже проецируют каждую остановку один раз)
+ * - контекст неизменяем: его можно разделять между потоками пакетного экспорта
+ * - после добавления остановок в каталог контекст нужно пересоздать
+ **************************************************************************************************/
+class RenderContext {
+public:
+    RenderContext(const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+                  double width = 800.0,
+                  double height = 600.0,
+                  double padding = 50.0,
+                  double top_margin = 70.0);
+
+    double Width() const { return width_; }
+    double Height() const { return height_; }
+    double Padding() const { return padding_; }
+    double TopMargin() const { return top_margin_; }
+
+    // точки по Stop::id (top_margin уже учтён)
+    const std::vector<Point>& Points() const { return points_; }
+    const Point& PointOf(const transport_catalogue::domain::Stop& stop) const { return points_[stop.id]; }
+
+private:
+    double width_;
+    double height_;
+    double padding_;
+    double top_margin_;
+    std::vector<Point> points_;
+};
+
+// ===================== Рендер против RenderContext =====================
+// Viewport общий (вся сеть), проекция не пересчитывается.
+void RenderNetworkSvg(SvgWriter& out, const RenderContext& ctx,
+                      const transport_catalogue::catalogue::TransportCatalogue& catalogue);
+
+// ===================== Потоковые версии =====================
+// Пишут SVG прямо в SvgWriter (в файл или строку) — без промежуточных копий.
+void RenderBusSvg(SvgWriter& out,
+                  const transport_catalogue::domain::Bus& bus,
+                  double width = 800.0,
+                  double height = 600.0,
+                  double padding = 50.0);
+
+void RenderStopSvg(SvgWriter& out,
+                   const transport_catalogue::domain::Stop& stop,
+                   const std::vector<const transport_catalogue::domain::Bus*>& buses,
+                   double width = 800.0,
+                   double height = 600.0,
+                   double padding = 50.0);
+
+// ===================== Карта всей сети =====================
+// Все маршруты и остановки в одном SVG:
+// - каждая остановка проецируется один раз
+// - общий для нескольких маршрутов сегмент рисуется один раз (цвет — первого маршрута)
+// - подпись остановки — одна на остановку
+void RenderNetworkSvg(SvgWriter& out,
+                      const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+                      double width = 800.0,
+                      double height = 600.0,
+                      double padding = 50.0);
+
+// ===================== Тайловая пирамида =====================
+// Экспорт сети в тайлы <out_dir>/<z>/<x>/<y>.svg для веб-просмотрщика:
+// - уровень z=0 — вся сеть в одном тайле, уровень z — сетка 2^z x 2^z
+// - сегменты и остановки раскладываются по тайлам (binning по bbox)
+// - тайлы рендерятся параллельно в пуле потоков, каждый файл пишется независимо
+// - пустые тайлы не создаются
+struct TileExportOptions {
+    std::string out_dir = "tiles";
+    int max_zoom = 3;            // уровни 0..max_zoom
+    double tile_size = 256.0;    // сторона тайла в пикселях
+    std::size_t threads = 0;     // 0 -> по числу аппаратных потоков
+    int precision = 2;           // знаков после точки в координатах
+    bool compact = false;        // компактный SVG (<path> по цветам, <use>, CSS-классы)
+};
+
+struct TileExportResult {
+    std::size_t tiles_written = 0;
+    std::size_t tiles_empty = 0;   // пропущены (ничего не попало)
+    std::size_t tiles_failed = 0;  // не удалось записать файл
+};
+
+TileExportResult ExportTilePyramid(const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+                                   const TileExportOptions& options = {});
+
+// ===================== Пакетный экспорт =====================
+// Имя файла из имени маршрута/остановки: пробелы -> '_' (bus_<name>.svg / stop_<name>.svg)
+std::string MakeSafeFilename(std::string_view name);
+
+// Все маршруты (и по желанию все остановки с маршрутами) -> отдельные SVG в out_dir.
+// Рендер идёт в пуле потоков с кражей работы; у каждого потока свой буфер SvgWriter,
+// файлы пишутся независимо (запись одного потока перекрывается рендером других).
+// Пути назначаются ДО отправки задач: если два имени дают один файл ("A B" и "A_B",
+// дубли имён, имена, различающиеся только регистром), второй получает суффикс _2, _3, ...
+// и попадает в BatchExportResult::collisions — два потока никогда не пишут один путь.
+struct BatchExportOptions {
+    std::string out_dir = "svg_export";
+    bool include_stops = false;
+    std::size_t max_routes_per_stop = 0;  // 0 -> все маршруты остановки
+    std::size_t threads = 0;              // 0 -> по числу аппаратных потоков
+    int precision = 2;
+    bool compact = false;                 // компактный SVG (см. SvgWriter::SetCompact)
+    double width = 800.0;
+    double height = 600.0;
+    double padding = 50.0;
+};
+
+struct BatchExportResult {
+    std::size_t bus_files = 0;
+    std::size_t stop_files = 0;
+    std::size_t failed = 0;
+    std::vector<std::string> collisions;  // "<имя> -> <файл>" для переименованных из-за совпадения
+};
+
+BatchExportResult ExportAllSvgs(const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+                                const BatchExportOptions& options = {});
+
+// ===================== Строковые версии (как раньше) =====================
+// Точность чисел — SvgWriter::kDefaultPrecision (6 знаков, как std::fixed << setprecision(6))
+
 std::string RenderBusSvg(const transport_catalogue::domain::Bus& bus,
                          double width = 800.0,
                          double height = 600.0,
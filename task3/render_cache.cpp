@@ -0,0 +1,125 @@
+// render_cache.cpp
+#include "render_cache.h"
+
+#include <functional>
+#include <utility>
+
+#include "map_renderer.h"
+#include "svg_writer.h"
+
+namespace transport_catalogue::render {
+
+namespace detail {
+
+constexpr std::uint64_t kFnvOffset = 14695981039346656037ULL;
+constexpr std::uint64_t kFnvPrime  = 1099511628211ULL;
+
+static void HashCombine(std::size_t& seed, std::size_t h) {
+    seed ^= h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+} // namespace detail
+
+std::uint64_t ContentHash(std::string_view bytes) {
+    std::uint64_t h = detail::kFnvOffset;
+    for (unsigned char c : bytes) {
+        h ^= c;
+        h *= detail::kFnvPrime;
+    }
+    return h;
+}
+
+bool RenderCache::Key::operator==(const Key& o) const {
+    return object == o.object && buses == o.buses
+        && width == o.width && height == o.height && padding == o.padding
+        && precision == o.precision && compact == o.compact && version == o.version;
+}
+
+std::size_t RenderCache::KeyHasher::operator()(const Key& k) const noexcept {
+    std::size_t seed = std::hash<const void*>{}(k.object);
+    for (const void* b : k.buses) {
+        detail::HashCombine(seed, std::hash<const void*>{}(b));
+    }
+    detail::HashCombine(seed, std::hash<double>{}(k.width));
+    detail::HashCombine(seed, std::hash<double>{}(k.height));
+    detail::HashCombine(seed, std::hash<double>{}(k.padding));
+    detail::HashCombine(seed, std::hash<int>{}(k.precision));
+    detail::HashCombine(seed, std::hash<bool>{}(k.compact));
+    detail::HashCombine(seed, std::hash<std::uint64_t>{}(k.version));
+    return seed;
+}
+
+RenderCache::RenderCache(std::size_t max_entries)
+    : max_entries_(max_entries == 0 ? 1 : max_entries) {
+}
+
+template <typename RenderFn>
+CachedSvg RenderCache::GetOrRender(Key key, RenderFn&& render) {
+    {
+        std::lock_guard lock(mutex_);
+        if (auto it = index_.find(key); it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            ++hits_;
+            return {it->second->second, true};
+        }
+        ++misses_;
+    }
+
+    // рендер — без блокировки (другие потоки в это время могут читать кеш)
+    SvgWriter svg(key.precision);
+    svg.SetCompact(key.compact);
+    render(svg);
+
+    auto result = std::make_shared<RenderedSvg>();
+    result->bytes = svg.TakeString();
+    result->hash = ContentHash(result->bytes);
+
+    std::lock_guard lock(mutex_);
+    if (auto it = index_.find(key); it != index_.end()) {
+        // кто-то успел отрендерить тот же ключ — байты совпадают, оставляем имеющиеся
+        return {it->second->second, false};
+    }
+
+    lru_.emplace_front(key, result);
+    index_.emplace(std::move(key), lru_.begin());
+
+    if (lru_.size() > max_entries_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+    return {std::move(result), false};
+}
+
+CachedSvg RenderCache::GetBus(const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+                              const transport_catalogue::domain::Bus& bus,
+                              double width, double height, double padding, int precision,
+                              bool compact) {
+    Key key{&bus, {}, width, height, padding, precision, compact, catalogue.GetVersion()};
+    return GetOrRender(std::move(key), [&](SvgWriter& svg) {
+        RenderBusSvg(svg, bus, width, height, padding);
+    });
+}
+
+CachedSvg RenderCache::GetStop(const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+                               const transport_catalogue::domain::Stop& stop,
+                               const std::vector<const transport_catalogue::domain::Bus*>& buses,
+                               double width, double height, double padding, int precision,
+                               bool compact) {
+    Key key{&stop, {buses.begin(), buses.end()}, width, height, padding, precision, compact,
+            catalogue.GetVersion()};
+    return GetOrRender(std::move(key), [&](SvgWriter& svg) {
+        RenderStopSvg(svg, stop, buses, width, height, padding);
+    });
+}
+
+std::size_t RenderCache::Hits() const {
+    std::lock_guard lock(mutex_);
+    return hits_;
+}
+
+std::size_t RenderCache::Misses() const {
+    std::lock_guard lock(mutex_);
+    return misses_;
+}
+
+} // namespace transport_catalogue::render
@@ -0,0 +1,95 @@
+// render_cache.h
+#pragma once
+
+/**************************************************************************************************
+ * RenderCache — кеш готовых SVG (байты + хеш содержимого)
+ *
+ * Ключ: (маршрут ИЛИ остановка + список маршрутов на карте, width, height, padding,
+ *        точность чисел, компактный режим, версия каталога)
+ *  - рендер детерминирован (порядок элементов не зависит от адресов), поэтому
+ *    одинаковый ключ = одинаковые байты
+ *  - версия каталога (TransportCatalogue::GetVersion) отсекает устаревшие записи
+ *  - вытеснение: LRU, не больше max_entries записей
+ *  - потокобезопасен (один mutex); сам рендер при промахе идёт БЕЗ блокировки
+ **************************************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "transport_catalogue.h"
+
+namespace transport_catalogue::render {
+
+struct RenderedSvg {
+    std::string bytes;
+    std::uint64_t hash = 0;  // FNV-1a 64 от bytes
+};
+
+struct CachedSvg {
+    std::shared_ptr<const RenderedSvg> svg;
+    bool hit = false;  // взято из кеша (без рендера)
+};
+
+// FNV-1a 64: хеш содержимого SVG (для сравнения/ETag), не криптографический
+std::uint64_t ContentHash(std::string_view bytes);
+
+class RenderCache {
+public:
+    explicit RenderCache(std::size_t max_entries = 256);
+
+    CachedSvg GetBus(
+        const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+        const transport_catalogue::domain::Bus& bus,
+        double width = 800.0, double height = 600.0, double padding = 50.0,
+        int precision = 6, bool compact = false);
+
+    CachedSvg GetStop(
+        const transport_catalogue::catalogue::TransportCatalogue& catalogue,
+        const transport_catalogue::domain::Stop& stop,
+        const std::vector<const transport_catalogue::domain::Bus*>& buses,
+        double width = 800.0, double height = 600.0, double padding = 50.0,
+        int precision = 6, bool compact = false);
+
+    std::size_t Hits() const;
+    std::size_t Misses() const;
+
+private:
+    struct Key {
+        const void* object = nullptr;  // Bus* или Stop*
+        std::vector<const void*> buses; // маршруты на карте остановки (пусто для маршрута)
+        double width = 0.0;
+        double height = 0.0;
+        double padding = 0.0;
+        int precision = 0;
+        bool compact = false;
+        std::uint64_t version = 0;
+
+        bool operator==(const Key& o) const;
+    };
+
+    struct KeyHasher {
+        std::size_t operator()(const Key& k) const noexcept;
+    };
+
+    using Lru = std::list<std::pair<Key, std::shared_ptr<const RenderedSvg>>>;
+
+    template <typename RenderFn>
+    CachedSvg GetOrRender(Key key, RenderFn&& render);
+
+    std::size_t max_entries_;
+
+    mutable std::mutex mutex_;
+    Lru lru_;  // front — самый свежий
+    std::unordered_map<Key, Lru::iterator, KeyHasher> index_;
+    std::size_t hits_ = 0;
+    std::size_t misses_ = 0;
+};
+
+} // namespace transport_catalogue::render
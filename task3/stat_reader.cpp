@@ -43,7 +43,7 @@ static void PrintStop(const transport_catalogue::catalogue::TransportCatalogue&
         return;
     }
 
-    const auto& buses_set = db.GetBusesByStop(stop);
+    const auto buses_set = db.GetBusSpanByStop(stop);
 
     if (buses_set.empty()) {
         out << "Stop " << name << ": no buses\n";
@@ -84,4 +84,41 @@ void ParseAndPrintStat(const transport_catalogue::catalogue::TransportCatalogue&
     }
 }
 
+void PrintMemoryUsage(const transport_catalogue::catalogue::MemoryReport& report,
+                      std::ostream& out) {
+    const std::size_t total = report.TotalBytes();
+
+    // доля печатается с одним знаком: флаги и точность потока возвращаются на выходе
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+
+    out << "Memory usage ESTIMATE (container sizes, not RSS; malloc overhead not counted):\n";
+    for (const auto& e : report.entries) {
+        const double share = total ? 100.0 * static_cast<double>(e.bytes) / total : 0.0;
+        out << "  " << std::left << std::setw(18) << e.name << std::right
+            << std::setw(10) << e.count << " items "
+            << std::setw(12) << e.bytes << " bytes "
+            << std::fixed << std::setprecision(1) << std::setw(5) << share << "%\n";
+    }
+    out << "  " << std::left << std::setw(18) << "total (est.)" << std::right
+        << std::setw(10) << "" << "       "
+        << std::setw(12) << total << " bytes\n";
+    out << "  " << std::left << std::setw(18) << "arena blocks" << std::right
+        << std::setw(10) << report.arena_blocks << " blocks"
+        << std::setw(12) << report.arena_bytes << " bytes (deque blocks, from the allocator)\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void PrintMemoryUsageCsv(const transport_catalogue::catalogue::MemoryReport& report,
+                         std::ostream& out) {
+    out << "structure,items,bytes_estimate\n";
+    for (const auto& e : report.entries) {
+        out << e.name << ',' << e.count << ',' << e.bytes << '\n';
+    }
+    out << "total,," << report.TotalBytes() << '\n';
+    out << "arena_blocks," << report.arena_blocks << ',' << report.arena_bytes << '\n';
+}
+
 } // namespace transport_catalogue::stat
@@ -18,6 +18,15 @@ void ParseAndPrintStat(const transport_catalogue::catalogue::TransportCatalogue&
                        std::string_view request,
                        std::ostream& output);
 
+// Печать отчёта TransportCatalogue::MemoryUsage() (таблица: структура / элементы / байты)
+void PrintMemoryUsage(const transport_catalogue::catalogue::MemoryReport& report,
+                      std::ostream& output);
+
+// Тот же отчёт в CSV (structure,items,bytes_estimate) — для скриптов, сравнивающих раскладки
+// (main.cpp: --memory-report вместе с --compress-routes / --hilbert)
+void PrintMemoryUsageCsv(const transport_catalogue::catalogue::MemoryReport& report,
+                         std::ostream& output);
+
 } // namespace transport_catalogue::stat
 
 // COMPAT
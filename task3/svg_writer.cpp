@@ -0,0 +1,292 @@
+// svg_writer.cpp
+#include "svg_writer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**************************************************************************************************
+ * Реализация SvgWriter:
+ *   - detail::FormatFixed   — быстрый форматтер double с фиксированной точностью
+ *   - detail::OpenFd/...    — тонкая обёртка над POSIX/Win32 дескрипторами
+ **************************************************************************************************/
+
+namespace transport_catalogue::render {
+
+namespace detail {
+
+namespace {
+
+constexpr int kMaxFastPrecision = 9;
+// |v| * 10^precision < 2^52: у произведения есть дробные биты, ошибка его округления < 0.5,
+// и правило округления ниже точное. Предел по |v| поэтому падает с ростом точности
+// (precision 2 — до 4.5e13, precision 9 — до 4.5e6); дальше — snprintf.
+constexpr double kMaxFastScaled = 4503599627370496.0;  // 2^52
+
+constexpr unsigned long long kPow10[kMaxFastPrecision + 1] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+    1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL
+};
+
+int OpenFd(const std::string& path) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+}
+
+bool WriteFd(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        const int n = _write(fd, data, static_cast<unsigned>(size));
+#else
+        const auto n = ::write(fd, data, size);
+#endif
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// Точное произведение: a * b == hi + lo (lo — ошибка округления hi).
+// С аппаратным FMA — одна инструкция, иначе разбиение Вельткампа/Деккера.
+void TwoProduct(double a, double b, double& hi, double& lo) {
+    hi = a * b;
+#ifdef FP_FAST_FMA
+    lo = std::fma(a, b, -hi);
+#else
+    constexpr double kSplitter = 134217729.0;  // 2^27 + 1
+    auto split = [kSplitter](double x, double& high, double& low) {
+        const double t = kSplitter * x;
+        high = t - (t - x);
+        low = x - high;
+    };
+    double ah, al, bh, bl;
+    split(a, ah, al);
+    split(b, bh, bl);
+    lo = ((ah * bh - hi) + ah * bl + al * bh) + al * bl;
+#endif
+}
+
+// |v| * 10^precision, округлённое до целого как у printf: по ТОЧНОМУ значению произведения,
+// половина — к чётному. false — вне быстрого диапазона (inf/nan, большие числа при данной
+// точности, точность > kMaxFastPrecision): там округляет сам snprintf.
+// scaled + error == |v| * scale точно; floor(scaled) и scaled - floor(scaled) тоже точны
+// (scaled < 2^52). Если дробная часть scaled не равна 0.5, её отличие от 0.5 (>= ulp)
+// больше |error| (<= ulp / 2) — решает она; иначе решает знак error, а при error == 0
+// это настоящая половина.
+bool RoundScaled(double v, int precision, unsigned long long& rounded) {
+    if (!std::isfinite(v) || precision < 0 || precision > kMaxFastPrecision
+        || std::fabs(v) * static_cast<double>(kPow10[precision]) >= kMaxFastScaled) {
+        return false;
+    }
+    double scaled = 0.0;
+    double error = 0.0;
+    TwoProduct(std::fabs(v), static_cast<double>(kPow10[precision]), scaled, error);
+    const double whole = std::floor(scaled);
+    const double above_half = (scaled - whole) - 0.5;
+
+    rounded = static_cast<unsigned long long>(whole);
+    if (above_half > 0.0 || (above_half == 0.0 && (error > 0.0 || (error == 0.0 && rounded % 2 != 0)))) {
+        ++rounded;
+    }
+    return true;
+}
+
+bool CloseFd(int fd) {
+#ifdef _WIN32
+    return _close(fd) == 0;
+#else
+    return ::close(fd) == 0;
+#endif
+}
+
+} // namespace
+
+std::size_t FormatFixed(char* out, double v, int precision) {
+    // редкие случаи (inf/nan, большие числа при данной точности, большая точность) — через snprintf
+    unsigned long long rounded = 0;
+    if (!RoundScaled(v, precision, rounded)) {
+        const int n = std::snprintf(out, 32 + static_cast<std::size_t>(precision < 0 ? 0 : precision),
+                                    "%.*f", precision, v);
+        return n > 0 ? static_cast<std::size_t>(n) : 0;
+    }
+
+    char* p = out;
+    if (std::signbit(v)) {
+        *p++ = '-';
+    }
+
+    const unsigned long long scale = kPow10[precision];
+    unsigned long long int_part = rounded / scale;
+    unsigned long long frac_part = rounded % scale;
+
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + int_part % 10);
+        int_part /= 10;
+    } while (int_part != 0);
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+
+    if (precision > 0) {
+        *p++ = '.';
+        for (int i = precision - 1; i >= 0; --i) {
+            p[i] = static_cast<char>('0' + frac_part % 10);
+            frac_part /= 10;
+        }
+        p += precision;
+    }
+
+    return static_cast<std::size_t>(p - out);
+}
+
+} // namespace detail
+
+
+SvgWriter::SvgWriter(int precision, std::size_t buffer_size)
+    : flush_threshold_(buffer_size)
+    , precision_(precision) {
+    buf_.reserve(buffer_size + 256);
+}
+
+SvgWriter::~SvgWriter() {
+    Close();
+}
+
+bool SvgWriter::Open(const std::string& path) {
+    Close();
+    buf_.clear();
+    failed_ = false;
+    fd_ = detail::OpenFd(path);
+    return fd_ >= 0;
+}
+
+bool SvgWriter::Close() {
+    if (fd_ < 0) {
+        return !failed_;
+    }
+    Flush();
+    if (!detail::CloseFd(fd_)) {
+        failed_ = true;
+    }
+    fd_ = -1;
+    return !failed_;
+}
+
+std::string SvgWriter::TakeString() {
+    std::string out;
+    if (fd_ < 0) {
+        out.swap(buf_);
+        buf_.reserve(flush_threshold_ + 256);
+    }
+    return out;
+}
+
+void SvgWriter::Flush() {
+    if (fd_ < 0 || buf_.empty()) {
+        return;
+    }
+    if (!detail::WriteFd(fd_, buf_.data(), buf_.size())) {
+        failed_ = true;
+    }
+    buf_.clear();
+}
+
+void SvgWriter::MaybeFlush() {
+    if (fd_ >= 0 && buf_.size() >= flush_threshold_) {
+        Flush();
+    }
+}
+
+SvgWriter& SvgWriter::operator<<(std::string_view s) {
+    buf_.append(s.data(), s.size());
+    MaybeFlush();
+    return *this;
+}
+
+SvgWriter& SvgWriter::operator<<(char c) {
+    buf_.push_back(c);
+    MaybeFlush();
+    return *this;
+}
+
+SvgWriter& SvgWriter::operator<<(double v) {
+    char tmp[64];
+    const int precision = precision_ > 30 ? 30 : precision_;
+    std::size_t n = detail::FormatFixed(tmp, v, precision);
+
+    if (compact_ && precision > 0 && std::isfinite(v)) {
+        // "12.500" -> "12.5", "3.000" -> "3"
+        while (tmp[n - 1] == '0') --n;
+        if (tmp[n - 1] == '.') --n;
+    }
+
+    buf_.append(tmp, n);
+    MaybeFlush();
+    return *this;
+}
+
+double SvgWriter::Round(double v) const {
+    // то же округление, что и в operator<<(double): иначе относительные приращения путей
+    // (разности округлённых точек) разойдутся с напечатанными абсолютными координатами
+    const int precision = precision_ > 30 ? 30 : precision_;
+    if (!std::isfinite(v)) {
+        return v;
+    }
+    unsigned long long rounded = 0;
+    if (detail::RoundScaled(v, precision, rounded)) {
+        // rounded < 2^52 и 10^precision точны в double: частное — ближайшее к напечатанному
+        const double r = static_cast<double>(rounded) / static_cast<double>(detail::kPow10[precision]);
+        return std::signbit(v) ? -r : r;
+    }
+    // редкий путь — разбираем ровно то, что напечатал бы snprintf
+    const int n = std::snprintf(nullptr, 0, "%.*f", precision, v);
+    if (n <= 0) {
+        return v;
+    }
+    std::string text(static_cast<std::size_t>(n), '\0');
+    std::snprintf(text.data(), text.size() + 1, "%.*f", precision, v);
+    return std::strtod(text.c_str(), nullptr);
+}
+
+void SvgWriter::WriteSigned(long long v) {
+    if (v < 0) {
+        buf_.push_back('-');
+        // -(v+1)+1: без переполнения на LLONG_MIN
+        WriteUnsigned(static_cast<unsigned long long>(-(v + 1)) + 1);
+        return;
+    }
+    WriteUnsigned(static_cast<unsigned long long>(v));
+}
+
+void SvgWriter::WriteUnsigned(unsigned long long v) {
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    while (n > 0) {
+        buf_.push_back(digits[--n]);
+    }
+    MaybeFlush();
+}
+
+} // namespace transport_catalogue::render
@@ -0,0 +1,107 @@
+// svg_writer.h
+#pragma once
+
+/**************************************************************************************************
+ * SvgWriter — потоковая запись SVG без std::ostringstream
+ *
+ * Зачем:
+ *   - раньше весь SVG собирался в ostringstream (std::fixed << setprecision(6)),
+ *     затем копировался в std::string, затем ещё раз — в ofstream
+ *   - теперь элементы пишутся прямо в большой переиспользуемый буфер,
+ *     который сбрасывается в файловый дескриптор по мере заполнения
+ *
+ * Два режима:
+ *   - строка:  SvgWriter w;              -> всё копится в буфере, забрать через TakeString()
+ *   - файл:    SvgWriter w; w.Open(path) -> буфер сбрасывается в fd, Close() дописывает хвост
+ *
+ * Числа с плавающей точкой печатаются быстрым форматтером с фиксированной точностью
+ * (аналог std::fixed << setprecision(precision)); точность настраивается.
+ *
+ * Компактный режим (SetCompact(true)):
+ *   - числа без хвостовых нулей ("12.50" -> "12.5", "3.00" -> "3")
+ *   - рендер (map_renderer) по этому флагу пишет <path>/<use>/CSS-классы вместо
+ *     отдельных <line>/<text> с inline-атрибутами
+ **************************************************************************************************/
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace transport_catalogue::render {
+
+class SvgWriter {
+public:
+    static constexpr int kDefaultPrecision = 6;
+    static constexpr std::size_t kDefaultBufferSize = std::size_t{1} << 16;
+
+    explicit SvgWriter(int precision = kDefaultPrecision,
+                       std::size_t buffer_size = kDefaultBufferSize);
+    ~SvgWriter();
+
+    SvgWriter(const SvgWriter&) = delete;
+    SvgWriter& operator=(const SvgWriter&) = delete;
+
+    // ---------- файловый режим ----------
+    // Открывает файл на запись (с усечением). Буфер переиспользуется между файлами.
+    bool Open(const std::string& path);
+    // Сбрасывает буфер и закрывает файл. Возвращает false, если была ошибка записи.
+    bool Close();
+    bool IsOpen() const { return fd_ >= 0; }
+
+    // ---------- строковый режим ----------
+    // Забирает накопленный текст (только если файл не открыт) и очищает буфер.
+    std::string TakeString();
+
+    void SetPrecision(int precision) { precision_ = precision; }
+    int GetPrecision() const { return precision_; }
+
+    void SetCompact(bool compact) { compact_ = compact; }
+    bool IsCompact() const { return compact_; }
+
+    // Значение, округлённое так же, как его напечатает operator<<(double)
+    double Round(double v) const;
+
+    // Принудительно сбросить буфер в файл (в строковом режиме ничего не делает)
+    void Flush();
+
+    SvgWriter& operator<<(std::string_view s);
+    SvgWriter& operator<<(const char* s) { return *this << std::string_view(s); }
+    SvgWriter& operator<<(char c);
+    SvgWriter& operator<<(double v);
+
+    template <typename T,
+              std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char>
+                               && !std::is_same_v<T, bool>, int> = 0>
+    SvgWriter& operator<<(T v) {
+        if constexpr (std::is_signed_v<T>) {
+            WriteSigned(static_cast<long long>(v));
+        } else {
+            WriteUnsigned(static_cast<unsigned long long>(v));
+        }
+        return *this;
+    }
+
+private:
+    void WriteSigned(long long v);
+    void WriteUnsigned(unsigned long long v);
+    void MaybeFlush();
+
+    std::string buf_;
+    std::size_t flush_threshold_;
+    int precision_;
+    bool compact_ = false;
+    int fd_ = -1;
+    bool failed_ = false;
+};
+
+namespace detail {
+
+// Пишет v в out с precision знаками после точки — байт в байт как printf("%.*f")
+// (точное округление, половина — к чётному; вне быстрого диапазона — сам snprintf).
+// Возвращает число записанных символов. out должен вмещать не меньше 32 + precision байт.
+std::size_t FormatFixed(char* out, double v, int precision);
+
+} // namespace detail
+
+} // namespace transport_catalogue::render
@@ -0,0 +1,189 @@
+// thread_pool.h
+#pragma once
+
+/**************************************************************************************************
+ * ThreadPool — пул потоков с кражей работы (work stealing) для параллельного экспорта SVG
+ *
+ * - Submit(task): положить задачу в очередь (из потока пула — в СВОЮ очередь,
+ *                 снаружи — по кругу в очереди воркеров)
+ * - Wait():       дождаться, пока ВСЕ отправленные задачи выполнятся
+ *                 (нельзя вызывать из задачи — это deadlock)
+ * - деструктор:   дожидается очередей и останавливает потоки
+ *
+ * Воркер берёт задачи с КОНЦА своей очереди (LIFO, тёплый кеш), а когда она пуста —
+ * крадёт с НАЧАЛА чужих очередей: неравные по стоимости задачи (длинный маршрут vs короткий)
+ * сами разъезжаются по потокам.
+ *
+ * Задачи СНАРУЖИ кладутся в НАЧАЛО очереди: владелец выполняет их в порядке отправки (FIFO),
+ * поэтому ThreadPool(1) годится как фоновая очередь (интерактивный рендер в main.cpp).
+ *
+ * Задачи не должны бросать исключения (исключение в задаче = std::terminate): ловите их
+ * в самой задаче (см. обёртку Enqueue в main.cpp).
+ **************************************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace transport_catalogue::util {
+
+class ThreadPool {
+public:
+    static constexpr std::size_t kNotAWorker = static_cast<std::size_t>(-1);
+
+    // threads == 0 -> по числу аппаратных потоков
+    explicit ThreadPool(std::size_t threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        queues_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+        workers_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this, i] { WorkerLoop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        has_work_.notify_all();
+        for (std::thread& t : workers_) {
+            t.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t Size() const { return workers_.size(); }
+
+    // Номер воркера ЭТОГО пула в текущем потоке (0..Size()-1) или kNotAWorker
+    std::size_t CurrentWorker() const {
+        return owner_tls() == this ? WorkerIndex() : kNotAWorker;
+    }
+
+    void Submit(std::function<void()> task) {
+        ++pending_;
+
+        std::size_t target = CurrentWorker();
+        const bool external = (target == kNotAWorker);
+        if (external) {
+            target = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        }
+        {
+            // счётчик растёт ПОСЛЕ push, но под замком очереди: воркер, увидевший queued_ > 0,
+            // найдёт задачу, а снять её (и сделать --queued_) раньше инкремента не сможет
+            std::lock_guard lock(queues_[target]->mutex);
+            if (external) {
+                queues_[target]->tasks.push_front(std::move(task));
+            } else {
+                queues_[target]->tasks.push_back(std::move(task));
+            }
+            ++queued_;
+        }
+        {
+            // воркер проверяет queued_ под mutex_: пройдя через него, мы не попадём между
+            // его проверкой и засыпанием, и notify не потеряется
+            std::lock_guard lock(mutex_);
+        }
+        has_work_.notify_one();
+    }
+
+    void Wait() {
+        std::unique_lock lock(mutex_);
+        all_done_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    static std::size_t& WorkerIndex() {
+        thread_local std::size_t index = kNotAWorker;
+        return index;
+    }
+
+    bool TryPopOwn(std::size_t self, std::function<void()>& out) {
+        Queue& q = *queues_[self];
+        std::lock_guard lock(q.mutex);
+        if (q.tasks.empty()) {
+            return false;
+        }
+        out = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        --queued_;
+        return true;
+    }
+
+    bool TrySteal(std::size_t self, std::function<void()>& out) {
+        for (std::size_t k = 1; k < queues_.size(); ++k) {
+            Queue& q = *queues_[(self + k) % queues_.size()];
+            std::lock_guard lock(q.mutex);
+            if (q.tasks.empty()) {
+                continue;
+            }
+            out = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            --queued_;
+            return true;
+        }
+        return false;
+    }
+
+    void WorkerLoop(std::size_t self) {
+        WorkerIndex() = self;
+        owner_tls() = this;
+
+        std::function<void()> task;
+        while (true) {
+            if (TryPopOwn(self, task) || TrySteal(self, task)) {
+                task();
+                task = nullptr;
+                if (--pending_ == 0) {
+                    std::lock_guard lock(mutex_);
+                    all_done_.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock lock(mutex_);
+            has_work_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+            if (stopping_ && queued_ == 0) {
+                return;
+            }
+        }
+    }
+
+    // пул, которому принадлежит текущий поток (чтобы Submit из чужого пула не трогал наши очереди)
+    static const ThreadPool*& owner_tls() {
+        thread_local const ThreadPool* owner = nullptr;
+        return owner;
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> next_queue_{0};
+    std::atomic<std::size_t> queued_{0};   // задачи в очередях (ещё не взяты)
+    std::atomic<std::size_t> pending_{0};  // задачи отправлены, но ещё не завершены
+    bool stopping_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable has_work_;
+    std::condition_variable all_done_;
+};
+
+} // namespace transport_catalogue::util
@@ -1,9 +1,11 @@
 // transport_catalogue.cpp
 #include "transport_catalogue.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <string>
-#include <unordered_set>
+#include <utility>
 
 /**************************************************************************************************
  * FIX (по замечанию ревьюера):
@@ -17,13 +19,174 @@
 
 namespace transport_catalogue::catalogue {
 
+namespace detail {
+
+// ===================== Оценка памяти контейнеров =====================
+
+// Строка занимает кучу, только если её буфер не внутри самого объекта (не SSO):
+// размер SSO-буфера у каждой реализации свой, поэтому проверяется адрес, а не capacity.
+inline std::size_t StringHeapBytes(const std::string& s) {
+    const auto data = reinterpret_cast<std::uintptr_t>(s.data());
+    const auto self = reinterpret_cast<std::uintptr_t>(&s);
+    const bool inline_buffer = data >= self && data < self + sizeof(s);
+    return inline_buffer ? 0 : s.capacity() + 1;
+}
+
+template <typename T>
+std::size_t VectorBytes(const std::vector<T>& v) {
+    return sizeof(v) + v.capacity() * sizeof(T);
+}
+
+// deque: блоки и карта блоков — ровно то, что прошло через её аллокатор
+template <typename T, typename Alloc, typename Counter>
+std::size_t DequeBytes(const std::deque<T, Alloc>& d, const Counter& memory) {
+    return sizeof(d) + memory.Bytes();
+}
+
+// std::unordered_*: массив бакетов + узел на элемент (значение + указатель на следующий;
+// хеш указателей и чисел в узле не хранится). Модель, а не счётчик: узлы у общего new.
+template <typename Map>
+std::size_t UnorderedBytes(const Map& m) {
+    return sizeof(m) + m.bucket_count() * sizeof(void*)
+        + m.size() * (sizeof(typename Map::value_type) + sizeof(void*));
+}
+
+// util::FlatHashMap: контрольные байты + слоты одним блоком
+template <typename Map>
+std::size_t FlatMapBytes(const Map& m) {
+    return sizeof(m) + m.AllocatedBytes();
+}
+
+// Флаги сегментов маршрута (two-way / canonical), см. domain::SegmentFlags.
+// Рёбра кодируются парой id в uint64 и сортируются: O(n log n), без хеширования указателей.
+void FillSegmentFlags(domain::Route& route) {
+    // один последовательный проход по виду (в kDeltaVarint произвольный доступ — O(k))
+    std::vector<std::uint32_t> ids;
+    ids.reserve(route.stops.size());
+    for (auto it = route.stops.begin(); it != route.stops.end(); ++it) {
+        ids.push_back(it.Id());
+    }
+    const std::size_t n = ids.size() < 2 ? 0 : ids.size() - 1;
+
+    auto key = [](std::uint32_t from, std::uint32_t to) {
+        return (static_cast<std::uint64_t>(from) << 32) | to;
+    };
+
+    std::vector<std::uint64_t> edges;
+    edges.reserve(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        edges.push_back(key(ids[k], ids[k + 1]));
+    }
+    std::sort(edges.begin(), edges.end());
+
+    route.segments.Assign(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        const std::uint32_t from = ids[k];
+        const std::uint32_t to   = ids[k + 1];
+        const bool two_way = std::binary_search(edges.begin(), edges.end(), key(to, from));
+        route.segments.Set(k, two_way, from <= to);
+    }
+}
+
+// Хеш последовательности для hash-consing маршрутов (см. TransportCatalogue::InternRoute)
+std::uint64_t HashStopSequence(const std::vector<std::uint32_t>& ids, bool mirrored) {
+    std::uint64_t h = 0x9e3779b97f4a7c15ULL ^ (ids.size() * 2 + mirrored);
+    for (const std::uint32_t id : ids) {
+        h ^= id + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+bool SameStopSequence(const domain::StopSpan& stops, const std::vector<std::uint32_t>& ids,
+                      bool mirrored) {
+    if (stops.StoredSize() != ids.size() || stops.IsMirrored() != (mirrored && !ids.empty())) {
+        return false;
+    }
+    auto it = stops.begin();
+    for (const std::uint32_t id : ids) {
+        if (it.Id() != id) {
+            return false;
+        }
+        ++it;
+    }
+    return true;
+}
+
+// Статистика последовательности: один проход итератора
+domain::BusStat ComputeRouteStat(const domain::StopSpan& stops) {
+    domain::BusStat res;
+    res.found = true;
+    res.stops_count = stops.size();
+
+    // уникальные — по id хранимой части (сортировка копии вместо хеш-множества указателей);
+    // обратная половина линейного маршрута новых остановок не добавляет
+    std::vector<std::uint32_t> ids;
+    ids.reserve(stops.StoredSize());
+    for (auto it = stops.begin(); it != stops.StoredEnd(); ++it) {
+        ids.push_back(it.Id());
+    }
+    std::sort(ids.begin(), ids.end());
+    res.unique_stops = static_cast<std::size_t>(std::unique(ids.begin(), ids.end()) - ids.begin());
+
+    // длина — одним проходом итератора по полной последовательности (порядок сложения прежний)
+    double length = 0.0;
+    const domain::Stop* prev = nullptr;
+    for (const domain::Stop* s : stops) {
+        if (prev) {
+            length += transport_catalogue::geo::ComputeDistance(prev->coord, s->coord);
+        }
+        prev = s;
+    }
+    res.route_length = length;
+    return res;
+}
+
+// Номер клетки (x, y) решётки 2^order x 2^order на кривой Гильберта (классический xy2d)
+std::uint64_t HilbertIndex(std::uint32_t x, std::uint32_t y, int order) {
+    const std::uint32_t n = std::uint32_t{1} << order;
+    std::uint64_t d = 0;
+    for (std::uint32_t s = n / 2; s > 0; s /= 2) {
+        const std::uint32_t rx = (x & s) ? 1 : 0;
+        const std::uint32_t ry = (y & s) ? 1 : 0;
+        d += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+constexpr int kHilbertOrder = 16;  // решётка 65536 x 65536 над bbox сети
+
+} // namespace detail
+
+std::size_t MemoryReport::TotalBytes() const {
+    std::size_t total = 0;
+    for (const Entry& e : entries) {
+        total += e.bytes;
+    }
+    return total;
+}
+
 void TransportCatalogue::AddStop(const std::string& name, geo::Coordinates coord) {
+    AppendStop(name, coord);
+    ++version_;
+}
+
+void TransportCatalogue::AppendStop(std::string_view name, geo::Coordinates coord) {
     // Копируем name внутрь stops_ (там стабильная память для string_view ключей).
-    stops_.push_back(domain::Stop{name, coord});
+    stops_.push_back(domain::Stop{std::string(name), coord,
+                                  static_cast<std::uint32_t>(stops_.size())});
 
     const domain::Stop* p = &stops_.back();
     stop_by_name_[p->name] = p;      // string_view ключ указывает на p->name (стабильно)
     stop_order_.push_back(p);
+    top_two_by_stop_.emplace_back();
+    buses_by_stop_.emplace_back();
 }
 
 const std::vector<const domain::Stop*>& TransportCatalogue::GetAllStops() const {
@@ -37,15 +200,17 @@ const domain::Stop* TransportCatalogue::GetStopByIndex(std::size_t index) const
     return stop_order_[index - 1];
 }
 
+// COMPAT: последовательность остановок как есть (развёрнутая заранее) — хранится целиком
 void TransportCatalogue::AddBus(const std::string& name,
                                 const std::vector<std::string_view>& stop_names) {
-    buses_.push_back(domain::Bus{});
-    domain::Bus& b = buses_.back();
-
-    // Копируем имя в Bus (снова: оно должно жить столько же, сколько живёт каталог)
-    b.name = name;
+    AddBus(name, stop_names, true);
+}
 
-    b.stops.reserve(stop_names.size());
+void TransportCatalogue::AddBus(const std::string& name,
+                                const std::vector<std::string_view>& stop_names,
+                                bool is_roundtrip) {
+    std::vector<std::uint32_t> ids;
+    ids.reserve(stop_names.size());
 
     for (std::string_view sv : stop_names) {
         const domain::Stop* s = FindStop(sv);
@@ -53,27 +218,214 @@ void TransportCatalogue::AddBus(const std::string& name,
         // Если вход корректный (как в учебных задачах) — stop всегда существует.
         assert(s != nullptr && "Stop not found while adding bus (input should be valid)");
 
-        // После assert проверка "if(s)" уже не нужна (но оставлять можно, если хочешь safety)
-        b.stops.push_back(s);
+        ids.push_back(s->id);
+    }
+
+    AddBusByStopIds(name, ids, is_roundtrip);
+}
+
+void TransportCatalogue::AddBusByStopIds(const std::string& name,
+                                         const std::vector<std::uint32_t>& stop_ids,
+                                         bool is_roundtrip) {
+    const domain::Bus& b = AppendBus(name, stop_ids, is_roundtrip);
+    for (const std::uint32_t id : stop_ids) {
+        AppendBusToStop(id, &b);
+    }
+    ++version_;
+}
+
+domain::Bus& TransportCatalogue::AppendBus(std::string_view name,
+                                           const std::vector<std::uint32_t>& stop_ids,
+                                           bool is_roundtrip) {
+    for ([[maybe_unused]] const std::uint32_t id : stop_ids) {
+        // Stop::id — позиция в stops_ (и до, и после перенумерации)
+        assert(id < stops_.size() && "Unknown stop id while adding bus");
+    }
+
+    // Копируем имя в Bus (снова: оно должно жить столько же, сколько живёт каталог)
+    buses_.push_back(domain::Bus{std::string(name), {}, is_roundtrip, nullptr});
+    domain::Bus& b = buses_.back();
+
+    // остановки дописываются в общее CSR-хранилище, маршрут получает вид на свой отрезок;
+    // одинаковые последовательности — одна Route (хранение, флаги сегментов, статистика)
+    b.route = InternRoute(stop_ids, !is_roundtrip);
+    b.stops = b.route->stops;
 
-        // здесь unordered_set — это ПРАВИЛЬНО: не будет дублей bus* у stop*
-        buses_by_stop_[s].insert(&b);
+    // длина маршрута известна только теперь — обновляем топ-2 всех его остановок
+    for (const domain::Stop* s : b.stops) {
+        UpdateShortestIntersection(s, &b);
     }
 
     bus_by_name_[b.name] = &b;
     bus_order_.push_back(&b);
+    return b;
+}
+
+void TransportCatalogue::BulkLoad(const std::vector<StopDescription>& stops,
+                                  const std::vector<BusDescription>& buses) {
+    // 1) всё, что растёт на элемент, — одним резервированием
+    const std::size_t total_stops = stops_.size() + stops.size();
+    const std::size_t total_buses = buses_.size() + buses.size();
+    stop_by_name_.reserve(total_stops);
+    stop_order_.reserve(total_stops);
+    top_two_by_stop_.reserve(total_stops);
+    buses_by_stop_.reserve(total_stops);
+    bus_by_name_.reserve(total_buses);
+    bus_order_.reserve(total_buses);
+    route_by_hash_.reserve(routes_.size() + buses.size());
+    route_stats_.reserve(routes_.size() + buses.size());
+
+    // 2) остановки и маршруты — как при поштучном добавлении, но без индекса остановка -> маршруты
+    for (const StopDescription& stop : stops) {
+        AppendStop(stop.name, stop.coord);
+    }
+    for (const BusDescription& bus : buses) {
+        AppendBus(bus.name, bus.stop_ids, bus.is_roundtrip);
+    }
+
+    // 3) индекс — одним проходом по всем маршрутам
+    BuildBusesByStop();
+    version_ += stops.size() + buses.size();
+}
+
+const domain::Route* TransportCatalogue::InternRoute(const std::vector<std::uint32_t>& ids,
+                                                     bool mirrored) {
+    const std::uint64_t hash = detail::HashStopSequence(ids, mirrored);
+    if (auto it = route_by_hash_.find(hash);
+        it != route_by_hash_.end() && detail::SameStopSequence(it->second->stops, ids, mirrored)) {
+        return it->second;
+    }
+
+    routes_.push_back(domain::Route{});
+    domain::Route& r = routes_.back();
+    r.id = route_stops_.Append(ids);  // номер в хранилище == позиция в routes_
+    r.stops = domain::StopSpan(&route_stops_, r.id, static_cast<std::uint32_t>(ids.size()), mirrored);
+    detail::FillSegmentFlags(r);
+
+    route_stats_.emplace_back();
+    route_by_hash_.emplace(hash, &r);
+    return &r;
+}
+
+std::size_t TransportCatalogue::GetRouteCount() const {
+    return routes_.size();
+}
+
+void TransportCatalogue::SetStopEncoding(domain::StopEncoding encoding) {
+    route_stops_.SetEncoding(encoding);
 }
 
 const std::unordered_set<const domain::Bus*>&
 TransportCatalogue::GetBusesByStop(const domain::Stop* stop) const {
     static const std::unordered_set<const domain::Bus*> kEmpty;
 
-    if (!stop) {
+    if (!stop || stop->id >= buses_by_stop_.size()) {
         return kEmpty;
     }
 
-    auto it = buses_by_stop_.find(stop);
-    return (it == buses_by_stop_.end()) ? kEmpty : it->second;
+    std::lock_guard lock(bus_sets_mutex_);
+    auto [it, inserted] = bus_sets_by_stop_.try_emplace(stop->id);
+    if (inserted) {
+        const domain::BusSpan span = GetBusSpanByStop(stop);
+        it->second.insert(span.begin(), span.end());
+    }
+    return it->second;
+}
+
+domain::BusSpan TransportCatalogue::GetBusSpanByStop(const domain::Stop* stop) const {
+    if (!stop || stop->id >= buses_by_stop_.size()) {
+        return {};
+    }
+
+    const StopBusList& list = buses_by_stop_[stop->id];
+    return {stop_bus_slots_.data() + list.offset, list.size};
+}
+
+void TransportCatalogue::AppendBusToStop(std::uint32_t stop_id, const domain::Bus* bus) {
+    StopBusList& list = buses_by_stop_[stop_id];
+
+    // маршрут добавляет свои остановки подряд, поэтому повтор — это всегда последний элемент
+    if (list.size != 0 && stop_bus_slots_[list.offset + list.size - 1] == bus) {
+        return;
+    }
+
+    if (list.size == list.capacity) {
+        const auto end = static_cast<std::uint32_t>(stop_bus_slots_.size());
+        const std::uint32_t capacity = std::max<std::uint32_t>(4, list.capacity * 2);
+        if (list.offset + list.capacity == end && list.capacity != 0) {
+            // отрезок и так последний — растёт на месте
+            stop_bus_slots_.resize(list.offset + capacity);
+        } else {
+            stop_bus_slots_.resize(end + capacity);
+            std::copy_n(stop_bus_slots_.begin() + list.offset, list.size,
+                        stop_bus_slots_.begin() + end);
+            list.offset = end;
+        }
+        list.capacity = capacity;
+    }
+
+    stop_bus_slots_[list.offset + list.size++] = bus;
+
+    // уже выданное GetBusesByStop множество остаётся актуальным (изменения каталога
+    // и так не конкурентны с чтением, поэтому без bus_sets_mutex_)
+    if (!bus_sets_by_stop_.empty()) {
+        if (auto it = bus_sets_by_stop_.find(stop_id); it != bus_sets_by_stop_.end()) {
+            it->second.insert(bus);
+        }
+    }
+}
+
+void TransportCatalogue::BuildBusesByStop() {
+    const std::size_t n = stops_.size();
+
+    // 1) пары (остановка, маршрут) без повторов внутри маршрута, маршруты — в порядке добавления;
+    // обратная половина линейного маршрута новых остановок не даёт — хватает хранимой части
+    struct StopBus {
+        std::uint32_t stop;
+        std::uint32_t bus;  // позиция в bus_order_
+    };
+    std::vector<StopBus> pairs;
+    std::vector<std::uint32_t> last_bus(n, ~std::uint32_t{0});
+    for (std::uint32_t i = 0; i < bus_order_.size(); ++i) {
+        const domain::StopSpan& stops = bus_order_[i]->stops;
+        for (auto it = stops.begin(); it != stops.StoredEnd(); ++it) {
+            const std::uint32_t id = it.Id();
+            if (last_bus[id] != i) {
+                last_bus[id] = i;
+                pairs.push_back({id, i});
+            }
+        }
+    }
+
+    // 2) сортировка подсчётом по id остановки (устойчивая: внутри остановки — порядок маршрутов)
+    std::vector<StopBusList> lists(n);
+    for (const StopBus& p : pairs) {
+        ++lists[p.stop].size;
+    }
+    std::uint32_t offset = 0;
+    for (StopBusList& list : lists) {
+        list.offset = offset;
+        list.capacity = list.size;
+        offset += list.size;
+        list.size = 0;
+    }
+
+    std::vector<const domain::Bus*> slots(pairs.size());
+    for (const StopBus& p : pairs) {
+        StopBusList& list = lists[p.stop];
+        slots[list.offset + list.size++] = bus_order_[p.bus];
+    }
+
+    buses_by_stop_ = std::move(lists);
+    stop_bus_slots_ = std::move(slots);
+
+    // выданные GetBusesByStop множества — заново по новому индексу (адреса те же)
+    for (auto& [stop_id, set] : bus_sets_by_stop_) {
+        const StopBusList& list = buses_by_stop_[stop_id];
+        set.clear();
+        set.insert(stop_bus_slots_.begin() + list.offset,
+                   stop_bus_slots_.begin() + list.offset + list.size);
+    }
 }
 
 const std::vector<const domain::Bus*>& TransportCatalogue::GetAllBuses() const {
@@ -87,6 +439,164 @@ const domain::Bus* TransportCatalogue::GetBusByIndex(std::size_t index) const {
     return bus_order_[index - 1];
 }
 
+namespace detail {
+
+// "a короче b": меньше остановок, при равенстве — меньше имя (порядок не зависит от адресов)
+static bool ShorterBus(const domain::Bus* a, const domain::Bus* b) {
+    if (a->stops.size() != b->stops.size()) {
+        return a->stops.size() < b->stops.size();
+    }
+    return a->name < b->name;
+}
+
+} // namespace detail
+
+void TransportCatalogue::UpdateShortestIntersection(const domain::Stop* stop, const domain::Bus* bus) {
+    TopTwoBuses& top = top_two_by_stop_[stop->id];
+    if (top.first == bus || top.second == bus) {
+        return;  // маршрут заходит на остановку не в первый раз
+    }
+
+    if (!top.first || detail::ShorterBus(bus, top.first)) {
+        top.second = top.first;
+        top.first = bus;
+    } else if (!top.second || detail::ShorterBus(bus, top.second)) {
+        top.second = bus;
+    } else {
+        return;
+    }
+
+    if (!top.second) {
+        return;
+    }
+
+    const std::size_t score = top.first->stops.size() + top.second->stops.size();
+    ShortestIntersection& best = shortest_intersection_;
+    if (!best.stop || score < best.score
+        || (score == best.score && (best.stop == stop || stop->name < best.stop->name))) {
+        best = {stop, top.first, top.second, score};
+    }
+}
+
+const ShortestIntersection& TransportCatalogue::GetShortestIntersection() const {
+    return shortest_intersection_;
+}
+
+void TransportCatalogue::ReorderStopsAlongHilbertCurve() {
+    const std::size_t n = stops_.size();
+    if (n < 2) {
+        return;
+    }
+
+    // 1) ключ Гильберта для каждой остановки (координаты — в решётку над bbox сети)
+    geo::BoundingBox box;
+    for (const domain::Stop& s : stops_) {
+        box.Extend(s.coord);
+    }
+    const double cells = static_cast<double>((std::uint32_t{1} << detail::kHilbertOrder) - 1);
+
+    auto to_cell = [cells](double v, double min, double max) {
+        if (max == min) return std::uint32_t{0};
+        return static_cast<std::uint32_t>((v - min) / (max - min) * cells);
+    };
+
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> order(n);  // (ключ, старый id)
+    for (std::uint32_t id = 0; id < n; ++id) {
+        const geo::Coordinates c = stops_[id].coord;
+        order[id] = {detail::HilbertIndex(to_cell(c.lng, box.min.lng, box.max.lng),
+                                          to_cell(c.lat, box.min.lat, box.max.lat),
+                                          detail::kHilbertOrder),
+                     id};
+    }
+    std::sort(order.begin(), order.end());  // равные ключи — по старому id (детерминированно)
+
+    // 2) новый id каждой старой остановки; пока Stop не переставлены, s->id — старый id,
+    // а позиция new_id в stops_ — адрес, по которому остановка окажется после перестановки
+    std::vector<std::uint32_t> new_id_of(n);
+    std::vector<TopTwoBuses> top_two(n);
+    for (std::uint32_t new_id = 0; new_id < n; ++new_id) {
+        const std::uint32_t old_id = order[new_id].second;
+        new_id_of[old_id] = new_id;
+        top_two[new_id] = top_two_by_stop_[old_id];
+        }
+
+    auto remap = [this, &new_id_of](const domain::Stop* s) { return &stops_[new_id_of[s->id]]; };
+
+    // 3) списки маршрутов + флаги сегментов (canonical зависит от id)
+    // CSR-хранилище перекодируется целиком (в kDeltaVarint меняются разности); номера
+    // последовательностей те же — Route::stops и Bus::stops остаются действительными;
+    // хеши зависят от id — индекс hash-consing строится заново
+    domain::StopSequenceStore remapped(&stops_);
+    remapped.SetEncoding(route_stops_.GetEncoding());
+    route_by_hash_.clear();
+    std::vector<std::uint32_t> ids;
+    for (const domain::Route& route : routes_) {
+        ids.clear();
+        for (auto it = route.stops.begin(); it != route.stops.StoredEnd(); ++it) {
+            ids.push_back(new_id_of[it.Id()]);
+        }
+        remapped.Append(ids);
+        route_by_hash_.emplace(detail::HashStopSequence(ids, route.stops.IsMirrored()), &route);
+    }
+    remapped.ShrinkToFit();
+    route_stops_ = std::move(remapped);
+
+    for (const domain::Stop*& s : stop_order_) {
+        s = remap(s);
+    }
+    if (shortest_intersection_.stop) {
+        shortest_intersection_.stop = remap(shortest_intersection_.stop);
+    }
+
+    // 4) переставляем сами Stop на месте, по циклам перестановки: в позицию new_id приходит
+    // order[new_id].second. Только перемещения (имена меняются владельцем без аллокаций),
+    // новое хранилище не заводится — арена не копит брошенные блоки deque
+    std::vector<bool> placed(n, false);
+    for (std::uint32_t start = 0; start < n; ++start) {
+        if (placed[start]) {
+            continue;
+        }
+        domain::Stop held = std::move(stops_[start]);
+        std::uint32_t pos = start;
+        while (true) {
+            placed[pos] = true;
+            const std::uint32_t from = order[pos].second;
+            if (from == start) {
+                stops_[pos] = std::move(held);
+                break;
+            }
+            stops_[pos] = std::move(stops_[from]);
+            pos = from;
+        }
+    }
+    for (std::uint32_t id = 0; id < n; ++id) {
+        stops_[id].id = id;
+    }
+
+    top_two_by_stop_ = std::move(top_two);
+
+    // ключи string_view — заново: короткие имена (SSO) переехали вместе со Stop
+    stop_by_name_.clear();
+    for (const domain::Stop& s : stops_) {
+        stop_by_name_[s.name] = &s;
+    }
+
+    for (domain::Route& route : routes_) {
+        detail::FillSegmentFlags(route);
+    }
+
+    // индекс остановка -> маршруты по новым id (заодно без дыр от поштучных вставок);
+    // множества GetBusesByStop были по старым id и старым Stop — сбрасываются вместе с ними
+    bus_sets_by_stop_.clear();
+    BuildBusesByStop();
+
+    ++version_;
+}
+
+std::uint64_t TransportCatalogue::GetVersion() const {
+    return version_;
+}
+
 const domain::Stop* TransportCatalogue::FindStop(std::string_view name) const {
     if (auto it = stop_by_name_.find(name); it != stop_by_name_.end()) {
         return it->second;
@@ -102,32 +612,102 @@ const domain::Bus* TransportCatalogue::FindBus(std::string_view name) const {
 }
 
 domain::BusStat TransportCatalogue::GetBusStat(std::string_view bus_name) const {
-    domain::BusStat res;
     const domain::Bus* bus = FindBus(bus_name);
     if (!bus) {
-        return res; // found=false по умолчанию
+        return {}; // found=false по умолчанию
     }
 
-    res.found = true;
-    res.stops_count = bus->stops.size();
+    // дубли маршрута (та же Route) получают уже посчитанную статистику
+    const std::uint32_t id = bus->route->id;
+    {
+        std::lock_guard lock(route_stats_mutex_);
+        if (route_stats_[id]) {
+            return *route_stats_[id];
+        }
+    }
 
-    std::unordered_set<const domain::Stop*> uniq;
-    uniq.reserve(bus->stops.size());
-    for (const domain::Stop* s : bus->stops) {
-        uniq.insert(s);
+    const domain::BusStat res = detail::ComputeRouteStat(bus->stops);
+
+    std::lock_guard lock(route_stats_mutex_);
+    route_stats_[id] = res;
+    return res;
+}
+
+MemoryReport TransportCatalogue::MemoryUsage() const {
+    MemoryReport report;
+
+    // stops_: блоки deque + имена, не влезшие в SSO
+    {
+        std::size_t bytes = detail::DequeBytes(stops_, stops_memory_);
+        for (const domain::Stop& s : stops_) {
+            bytes += detail::StringHeapBytes(s.name);
+        }
+        report.entries.push_back({"stops_", stops_.size(), bytes});
     }
-    res.unique_stops = uniq.size();
 
-    double length = 0.0;
-    for (std::size_t i = 1; i < bus->stops.size(); ++i) {
-        length += transport_catalogue::geo::ComputeDistance(
-            bus->stops[i - 1]->coord,
-            bus->stops[i]->coord
-        );
+    // buses_: блоки deque + имена (остановки и флаги — в общих Route)
+    {
+        std::size_t bytes = detail::DequeBytes(buses_, buses_memory_);
+        for (const domain::Bus& b : buses_) {
+            bytes += detail::StringHeapBytes(b.name);
+        }
+        report.entries.push_back({"buses_", buses_.size(), bytes});
     }
-    res.route_length = length;
 
-    return res;
+    // routes_: блоки deque + флаги сегментов уникальных последовательностей
+    {
+        std::size_t bytes = detail::DequeBytes(routes_, routes_memory_);
+        for (const domain::Route& r : routes_) {
+            bytes += r.segments.CapacityBytes();
+        }
+        report.entries.push_back({"routes_", routes_.size(), bytes});
+    }
+    report.entries.push_back({"route_by_hash_", route_by_hash_.size(),
+                              detail::FlatMapBytes(route_by_hash_)});
+    {
+        std::lock_guard lock(route_stats_mutex_);
+        report.entries.push_back({"route_stats_", route_stats_.size(),
+                                  detail::VectorBytes(route_stats_)});
+    }
+
+    // route_stops_: id (kPlain) или байты кодировки (kDeltaVarint) + смещения маршрутов
+    report.entries.push_back({"route_stops_", route_stops_.StoredStops(),
+                              sizeof(route_stops_) + route_stops_.CapacityBytes()});
+
+    report.entries.push_back({"stop_by_name_", stop_by_name_.size(),
+                              detail::FlatMapBytes(stop_by_name_)});
+    report.entries.push_back({"bus_by_name_", bus_by_name_.size(),
+                              detail::FlatMapBytes(bus_by_name_)});
+
+    // buses_by_stop_: отрезки по остановкам + общий массив указателей (с дырами, если были AddBus)
+    {
+        std::size_t pairs = 0;
+        for (const StopBusList& list : buses_by_stop_) {
+            pairs += list.size;
+        }
+        report.entries.push_back({"buses_by_stop_", pairs,
+                                  detail::VectorBytes(buses_by_stop_)
+                                      + stop_bus_slots_.capacity() * sizeof(const domain::Bus*)});
+    }
+
+    // множества, уже выданные GetBusesByStop (только запрошенные остановки)
+    {
+        std::lock_guard lock(bus_sets_mutex_);
+        std::size_t bytes = detail::UnorderedBytes(bus_sets_by_stop_);
+        for (const auto& [stop_id, set] : bus_sets_by_stop_) {
+            bytes += detail::UnorderedBytes(set) - sizeof(set);  // сам set — уже в узле
+        }
+        report.entries.push_back({"bus_sets_by_stop_", bus_sets_by_stop_.size(), bytes});
+    }
+
+    report.entries.push_back({"bus_order_", bus_order_.size(), detail::VectorBytes(bus_order_)});
+    report.entries.push_back({"stop_order_", stop_order_.size(), detail::VectorBytes(stop_order_)});
+    report.entries.push_back({"top_two_by_stop_", top_two_by_stop_.size(),
+                              detail::VectorBytes(top_two_by_stop_)});
+
+    report.arena_blocks = arena_upstream_.Blocks();
+    report.arena_bytes = arena_upstream_.Bytes();
+    return report;
 }
 
 } // namespace transport_catalogue::catalogue
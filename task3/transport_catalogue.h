@@ -16,7 +16,11 @@
  *     а реализация/структура прячется за namespaces.
  **************************************************************************************************/
 
+#include <cstdint>
 #include <deque>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -24,6 +28,7 @@
 #include <vector>
 
 #include "domain.h"  // domain::Stop, domain::Bus, domain::BusStat
+#include "flat_hash_map.h"  // util::FlatHashMap — индексы каталога
 #include "geo.h"     // geo::Coordinates, geo::ComputeDistance
 
 namespace transport_catalogue::catalogue {
@@ -37,11 +42,81 @@ struct StrViewHasher {
     }
 };
 
+// ===================== Отчёт о памяти =====================
+// ОЦЕНКА занимаемой памяти по каждой структуре каталога — не RSS.
+// - bytes: сам контейнер + его блоки/таблица + "хвосты" в куче (строки, вектора);
+//   блоки deque — точно (счётчик аллокатора), вектора и плоские таблицы — по ёмкости,
+//   узлы std::unordered_* — по модели (значение + указатель на следующий узел)
+// - count: число элементов в контейнере
+// Накладные расходы malloc (заголовки, выравнивание) не учитываются.
+struct MemoryReport {
+    struct Entry {
+        std::string_view name;
+        std::size_t count = 0;
+        std::size_t bytes = 0;
+    };
+
+    std::vector<Entry> entries;
+
+    // арена каталога: блоки, взятые у new/delete (контейнеры из entries живут внутри них)
+    std::size_t arena_blocks = 0;
+    std::size_t arena_bytes = 0;
+
+    std::size_t TotalBytes() const;
+};
+
+// ===================== Пересечение двух самых коротких маршрутов =====================
+// Остановка, через которую проходят два маршрута с наименьшей суммой числа остановок.
+// Короче = меньше stops.size(), при равенстве — меньше имя; при равном score — меньше имя остановки.
+struct ShortestIntersection {
+    const domain::Stop* stop = nullptr;   // nullptr — ни через одну остановку не идут 2 маршрута
+    const domain::Bus* first = nullptr;   // самый короткий маршрут остановки
+    const domain::Bus* second = nullptr;  // второй по длине
+    std::size_t score = 0;                // first->stops.size() + second->stops.size()
+};
+
+// ===================== Пакетная загрузка =====================
+// Описания для TransportCatalogue::BulkLoad. Имена копируются в каталог — вызывающему
+// достаточно, чтобы строки жили до конца вызова.
+struct StopDescription {
+    std::string_view name;
+    geo::Coordinates coord;
+};
+
+struct BusDescription {
+    std::string_view name;
+    std::vector<std::uint32_t> stop_ids;  // Stop::id (как в AddBusByStopIds)
+    bool is_roundtrip = false;  // как у domain::Bus и разборщика: по умолчанию линейный
+};
+
 // ----- Каталог -----
 class TransportCatalogue {
 public:
+    TransportCatalogue() = default;
+    // Bus::stops — виды на хранилища этого объекта: копия смотрела бы в оригинал
+    TransportCatalogue(const TransportCatalogue&) = delete;
+    TransportCatalogue& operator=(const TransportCatalogue&) = delete;
+
     void AddStop(const std::string& name, geo::Coordinates coord); // см -> cpp
     void AddBus (const std::string& name, const std::vector<std::string_view>& stop_names); // см -> cpp
+    // is_roundtrip = false: stop_names — прямая половина линейного маршрута (A, B, C),
+    // хранится один раз, Bus::stops отдаёт A, B, C, B, A
+    void AddBus (const std::string& name, const std::vector<std::string_view>& stop_names,
+                 bool is_roundtrip);
+    // То же по готовым Stop::id (без поиска по имени и хеширования строк): input_reader
+    // разрешает имена своей таблицей символов один раз на имя (см. также BulkLoad)
+    void AddBusByStopIds(const std::string& name, const std::vector<std::uint32_t>& stop_ids,
+                         bool is_roundtrip);
+
+    // Полная загрузка одним вызовом: результат тот же, что у AddStop по stops, затем
+    // AddBusByStopIds по buses (в том же порядке), но все структуры резервируются заранее,
+    // а индекс остановка -> маршруты строится одной сортировкой подсчётом, а не вставками.
+    // Новые остановки получают id подряд с GetAllStops().size() — на них можно ссылаться из buses.
+    void BulkLoad(const std::vector<StopDescription>& stops, const std::vector<BusDescription>& buses);
+
+    // Кодировка остановок маршрутов (см. domain::StopEncoding); только до первого AddBus.
+    // kDeltaVarint — для очень больших сетей: меньше памяти, чтение только последовательное.
+    void SetStopEncoding(domain::StopEncoding encoding);
 
     const domain::Stop* FindStop(std::string_view name) const;
     const domain::Bus*  FindBus (std::string_view name) const;
@@ -50,10 +125,17 @@ public:
 
     // ===================== Task2: Stop X =====================
     // Возвращает набор автобусов, проходящих через КОНКРЕТНУЮ остановку.
-    // - Если остановка не встречалась ни в одном маршруте -> вернётся пустой set.
-    // - Метод возвращает ссылку, поэтому для "пустого ответа" используется static-пустой set.
+    // - Если остановка не встречалась ни в одном маршруте -> вернётся пустое множество.
+    // - Прежний интерфейс: множество строится при первом запросе по остановке и дальше
+    //   пополняется AddBus/BulkLoad; ссылка живёт, пока жив каталог (кроме перенумерации
+    //   ReorderStopsAlongHilbertCurve — она заменяет и сами Stop).
     const std::unordered_set<const domain::Bus*>& GetBusesByStop(const domain::Stop* stop) const;
 
+    // То же без копирования: вид на индекс каталога (без повторов, в порядке добавления маршрутов).
+    // Действителен только до следующего AddBus/AddBusByStopIds/BulkLoad/перенумерации:
+    // список остановки при добавлении может переехать внутри индекса.
+    domain::BusSpan GetBusSpanByStop(const domain::Stop* stop) const;
+
     // ===================== SVG список (интерактив) =====================
     // вернуть список маршрутов в порядке добавления (1..N)
     const std::vector<const domain::Bus*>& GetAllBuses() const;
@@ -67,26 +149,148 @@ public:
     // получить остановку по порядковому номеру (1..N), иначе nullptr
     const domain::Stop* GetStopByIndex(std::size_t index) const;
 
+    // ===================== Лучшее пересечение =====================
+    // O(1): индекс "два кратчайших маршрута на остановку" + глобальный лучший
+    // обновляются в AddBus (маршруты только добавляются, поэтому score лишь уменьшается)
+    const ShortestIntersection& GetShortestIntersection() const;
+
+    // ===================== Пространственная перенумерация =====================
+    // Необязательный проход ПОСЛЕ загрузки (main.cpp: --hilbert): остановки переставляются
+    // на месте вдоль кривой Гильберта по координатам, Stop::id = новая позиция. Соседние по карте
+    // (а значит и по маршруту) остановки оказываются рядом в памяти; все индексы и списки
+    // маршрутов перестраиваются — это O(суммы длин маршрутов), вызывать один раз.
+    // - порядок GetAllStops()/GetStopByIndex() (порядок ввода) не меняется
+    // - ВСЕ ранее полученные указатели на Stop и их id становятся недействительными
+    //   (по тому же адресу теперь другая остановка)
+    void ReorderStopsAlongHilbertCurve();
+
+    // ===================== Общие последовательности =====================
+    // Число уникальных последовательностей остановок (Bus::route); <= числа маршрутов
+    std::size_t GetRouteCount() const;
+
+    // ===================== Версия данных =====================
+    // Растёт при каждом AddStop/AddBus: ключ для кешей, построенных по каталогу
+    std::uint64_t GetVersion() const;
+
+    // ===================== Память =====================
+    // Обходит каждый контейнер и оценивает его вес (см. MemoryReport)
+    MemoryReport MemoryUsage() const;
+
 private:
+    // ===================== Арена =====================
+    // Блоки deque хранилищ (stops_, buses_, routes_) берутся из монотонной арены:
+    // несколько больших блоков у new/delete, освобождение — разом при разрушении каталога.
+    // Арена ничего не освобождает по отдельности, поэтому в ней только то, что лишь растёт
+    // и не переезжает. Таблицы индексов при rehash бросают старые бакеты — они на обычной
+    // куче, как и крупные плоские массивы (списки, CSR, координаты) и имена (std::string).
+    // Считает живые блоки и байты, проходящие через него к upstream: у арены — её блоки
+    // у new/delete, у хранилищ — точный объём их блоков deque (для MemoryUsage).
+    class BlockCounter final : public std::pmr::memory_resource {
+    public:
+        explicit BlockCounter(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+            : upstream_(upstream) {}
+
+        std::size_t Blocks() const { return blocks_; }
+        std::size_t Bytes() const { return bytes_; }
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t align) override {
+            ++blocks_;
+            bytes_ += bytes;
+            return upstream_->allocate(bytes, align);
+        }
+        void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+            --blocks_;
+            bytes_ -= bytes;
+            upstream_->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::pmr::memory_resource* upstream_;
+        std::size_t blocks_ = 0;
+        std::size_t bytes_ = 0;
+    };
+
+    static constexpr std::size_t kArenaInitialBytes = std::size_t{1} << 16;
+
+    // объявлены первыми: контейнеры ниже создаются поверх арены и разрушаются раньше неё
+    BlockCounter arena_upstream_;
+    std::pmr::monotonic_buffer_resource arena_{kArenaInitialBytes, &arena_upstream_};
+
+    // счётчики поверх арены: сколько в ней занимает каждое хранилище
+    BlockCounter stops_memory_{&arena_};
+    BlockCounter buses_memory_{&arena_};
+    BlockCounter routes_memory_{&arena_};
+
     // физическое хранение (стабильные адреса, deque не "переезжает" как vector)
-    std::deque<domain::Stop> stops_;
-    std::deque<domain::Bus>  buses_;
+    std::pmr::deque<domain::Stop> stops_{&stops_memory_};
+    std::pmr::deque<domain::Bus>  buses_{&buses_memory_};
 
-    // индексы по имени (быстрый поиск)
-    std::unordered_map<std::string_view, const domain::Stop*, StrViewHasher, std::equal_to<>> stop_by_name_;
-    std::unordered_map<std::string_view, const domain::Bus*,  StrViewHasher, std::equal_to<>> bus_by_name_;
+    // уникальные последовательности остановок (Route::id = позиция) и их CSR-хранилище
+    // (последовательность i — i-я в route_stops_); Bus::route/Bus::stops ссылаются сюда
+    std::pmr::deque<domain::Route> routes_{&routes_memory_};
+    domain::StopSequenceStore route_stops_{&stops_};
 
-    // ===================== Task2: индекс Stop* -> множество Bus* =====================
-    // Ключ: указатель на Stop (адрес элемента в stops_)
-    // Значение: набор указателей на Bus (адреса элементов в buses_)
-    // unordered_set гарантирует отсутствие дублей.
-    std::unordered_map<const domain::Stop*, std::unordered_set<const domain::Bus*>> buses_by_stop_;
+    // hash-consing: хеш (id остановок + линейность) -> последовательность.
+    // При коллизии хешей разных последовательностей вторая просто не дедуплицируется.
+    util::FlatHashMap<std::uint64_t, const domain::Route*> route_by_hash_;
+    const domain::Route* InternRoute(const std::vector<std::uint32_t>& ids, bool mirrored);
+
+    // статистика по Route::id: считается при первом GetBusStat, общая для всех дублей
+    mutable std::vector<std::optional<domain::BusStat>> route_stats_;
+    mutable std::mutex route_stats_mutex_;
+
+    // индексы по имени (быстрый поиск; плоские таблицы с открытой адресацией, см. flat_hash_map.h)
+    util::FlatHashMap<std::string_view, const domain::Stop*, StrViewHasher, std::equal_to<>> stop_by_name_;
+    util::FlatHashMap<std::string_view, const domain::Bus*,  StrViewHasher, std::equal_to<>> bus_by_name_;
+
+    // ===================== Task2: индекс Stop -> список Bus* =====================
+    // CSR по Stop::id: список остановки — отрезок buses_by_stop_[id] в stop_bus_slots_,
+    // указатели на Bus без повторов, в порядке добавления маршрутов.
+    // - BuildBusesByStop (BulkLoad, перенумерация): сортировка подсчётом всех пар
+    //   (остановка, маршрут) — отрезки ровно по размеру, подряд, без дыр
+    // - AddBus: дописывание в отрезок; полный отрезок переезжает в конец массива с удвоенной
+    //   ёмкостью (старое место — дыра до следующей перестройки)
+    struct StopBusList {
+        std::uint32_t offset = 0;
+        std::uint32_t size = 0;
+        std::uint32_t capacity = 0;
+    };
+    std::vector<StopBusList> buses_by_stop_;   // по Stop::id
+    std::vector<const domain::Bus*> stop_bus_slots_;
+    void AppendBusToStop(std::uint32_t stop_id, const domain::Bus* bus);
+    void BuildBusesByStop();
+
+    // множества для GetBusesByStop (по Stop::id): только запрошенные остановки; узловая
+    // таблица — ссылки на множества не переезжают при её росте
+    mutable std::unordered_map<std::uint32_t, std::unordered_set<const domain::Bus*>> bus_sets_by_stop_;
+    mutable std::mutex bus_sets_mutex_;
+
+    // общая часть AddStop/BulkLoad и AddBusByStopIds/BulkLoad (без индекса остановка -> маршруты)
+    void AppendStop(std::string_view name, geo::Coordinates coord);
+    domain::Bus& AppendBus(std::string_view name, const std::vector<std::uint32_t>& stop_ids,
+                           bool is_roundtrip);
 
     // список в SVG (порядок добавления автобусов)
     std::vector<const domain::Bus*> bus_order_;
 
     // список остановок для интерактива (порядок добавления)
     std::vector<const domain::Stop*> stop_order_;
+
+    // два кратчайших маршрута каждой остановки (по Stop::id) + лучший по всему каталогу
+    struct TopTwoBuses {
+        const domain::Bus* first = nullptr;
+        const domain::Bus* second = nullptr;
+    };
+    void UpdateShortestIntersection(const domain::Stop* stop, const domain::Bus* bus);
+
+    std::vector<TopTwoBuses> top_two_by_stop_;
+
+    ShortestIntersection shortest_intersection_;
+
+    std::uint64_t version_ = 0;
 };
 
 }  // namespace transport_catalogue::catalogue